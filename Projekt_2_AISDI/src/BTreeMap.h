@@ -0,0 +1,809 @@
+#ifndef AISDI_MAPS_BTREEMAP_H
+#define AISDI_MAPS_BTREEMAP_H
+
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace aisdi {
+
+    //Słownik uporządkowany oparty o B+drzewo - ten sam interfejs co TreeMap.
+    //Węzły mają rozmiar kilku linii cache, więc wyszukiwanie to ~log_B(n) chybień zamiast ~log2(n).
+    //Elementy leżą w liściach połączonych listą (iteracja). Uwaga: w odróżnieniu od TreeMap
+    //wstawianie i usuwanie przesuwa elementy w liściach, więc unieważnia iteratory i referencje.
+    //Klucze w węzłach leżą w surowej pamięci - od KeyType wystarczy konstrukcja kopiująca i przenosząca
+    //(przeniesienie nie powinno rzucać); Compare jak w TreeMap, z wyszukiwaniem heterogenicznym.
+    template<typename KeyType, typename ValueType, typename Compare = std::less<KeyType>>
+    class BTreeMap {
+    public:
+        using key_type = KeyType;
+        using key_compare = Compare;
+        using mapped_type = ValueType;
+        using value_type = std::pair<const key_type, mapped_type>;
+        using size_type = std::size_t;
+        using reference = value_type&;
+        using const_reference = const value_type&;
+
+        class ConstIterator;
+
+        class Iterator;
+
+        using iterator = Iterator;
+        using const_iterator = ConstIterator;
+
+        static const size_type CacheLineSize = 64;
+        //Pojemności węzłów: ok. 4 linie cache na elementy liścia / klucze węzła wewnętrznego:
+        static const size_type LeafCapacity =
+                4 * CacheLineSize / sizeof(value_type) > 4 ? 4 * CacheLineSize / sizeof(value_type) : 4;
+        static const size_type InnerCapacity =
+                4 * CacheLineSize / sizeof(key_type) > 4 ? 4 * CacheLineSize / sizeof(key_type) : 4;
+
+        BTreeMap() : BTreeMap(Compare()) {}
+
+        explicit BTreeMap(const Compare& pCompare) : mRoot(nullptr), mFirst(nullptr), mLast(nullptr), mCount(0),
+                                                     mCompare(pCompare) {}
+
+        BTreeMap(std::initializer_list<value_type> list) : BTreeMap() {
+            for (auto&& item : list)
+                (*this)[item.first] = item.second;
+        }
+
+        BTreeMap(const BTreeMap& other) : BTreeMap(other.mCompare) {
+            for (auto&& item : other)
+                (*this)[item.first] = item.second;
+        }
+
+        BTreeMap(BTreeMap&& other) : BTreeMap(other.mCompare) {
+            swap(other);
+        }
+
+        ~BTreeMap() {
+            clear();
+        }
+
+        BTreeMap& operator=(const BTreeMap& other) {
+            if (this == &other)
+                return *this;
+            clear();
+            mCompare = other.mCompare;
+            for (auto&& item : other)
+                (*this)[item.first] = item.second;
+            return *this;
+        }
+
+        BTreeMap& operator=(BTreeMap&& other) {
+            if (this == &other)
+                return *this;
+            clear();
+            swap(other);
+            return *this;
+        }
+
+        bool isEmpty() const {
+            return mCount == 0;
+        }
+
+        mapped_type& operator[](const key_type& key) {
+            Leaf* leaf;
+            size_type index;
+            if (findSlot(key, leaf, index))//istniejący klucz - bez ścieżki wstawiania
+                return leaf->at(index)->second;
+            if (mRoot == nullptr)
+                mRoot = mFirst = mLast = new Leaf();
+            KeyHolder separator;
+            Node* right = nullptr;
+            value_type* item = insert(mRoot, key, separator, right);
+            if (right != nullptr) {//podział korzenia - drzewo rośnie o poziom
+                Inner* root = new Inner();
+                root->emplaceKey(0, std::move(*separator.get()));
+                root->mChildren[0] = mRoot;
+                root->mChildren[1] = right;
+                root->mCount = 1;
+                mRoot = root;
+            }
+            return item->second;
+        }
+
+        const mapped_type& valueOf(const key_type& key) const {
+            Leaf* leaf;
+            size_type index;
+            if (!findSlot(key, leaf, index))
+                throw std::out_of_range("Key not found.");
+            return leaf->at(index)->second;
+        }
+
+        mapped_type& valueOf(const key_type& key) {
+            return const_cast<mapped_type&>(static_cast<const BTreeMap*>(this)->valueOf(key));
+        }
+
+        const_iterator find(const key_type& key) const {
+            Leaf* leaf;
+            size_type index;
+            if (!findSlot(key, leaf, index))
+                return end();
+            return ConstIterator(*this, leaf, index);
+        }
+
+        iterator find(const key_type& key) {
+            return static_cast<const BTreeMap*>(this)->find(key);
+        }
+        //Wyszukiwanie heterogeniczne (tylko dla przezroczystego Compare):
+        template<typename K, typename C = Compare, typename = typename C::is_transparent>
+        const_iterator find(const K& key) const {
+            Leaf* leaf;
+            size_type index;
+            if (!findSlot(key, leaf, index))
+                return end();
+            return ConstIterator(*this, leaf, index);
+        }
+
+        template<typename K, typename C = Compare, typename = typename C::is_transparent>
+        iterator find(const K& key) {
+            return static_cast<const BTreeMap*>(this)->find(key);
+        }
+
+        void remove(const key_type& key) {
+            if (mRoot == nullptr)
+                throw std::out_of_range("Node not found.");
+            erase(mRoot, key);
+            if (!mRoot->mLeaf && mRoot->mCount == 0) {//korzeń z jednym dzieckiem - drzewo maleje o poziom
+                Inner* root = static_cast<Inner*>(mRoot);
+                mRoot = root->mChildren[0];
+                delete root;
+            } else if (mRoot->mLeaf && mRoot->mCount == 0) {
+                delete static_cast<Leaf*>(mRoot);
+                mRoot = mFirst = mLast = nullptr;
+            }
+        }
+
+        void remove(const const_iterator& it) {
+            if (it == end())
+                throw std::out_of_range("Removing end iterator");
+            remove(it->first);
+        }
+
+        size_type getSize() const {
+            return mCount;
+        }
+        //Pierwszy element o kluczu >= key (end, gdy brak):
+        const_iterator lowerBound(const key_type& key) const {
+            return boundIterator(key, false);
+        }
+
+        iterator lowerBound(const key_type& key) {
+            return static_cast<const BTreeMap*>(this)->lowerBound(key);
+        }
+
+        template<typename K, typename C = Compare, typename = typename C::is_transparent>
+        const_iterator lowerBound(const K& key) const {
+            return boundIterator(key, false);
+        }
+
+        template<typename K, typename C = Compare, typename = typename C::is_transparent>
+        iterator lowerBound(const K& key) {
+            return static_cast<const BTreeMap*>(this)->lowerBound(key);
+        }
+        //Pierwszy element o kluczu > key (end, gdy brak):
+        const_iterator upperBound(const key_type& key) const {
+            return boundIterator(key, true);
+        }
+
+        iterator upperBound(const key_type& key) {
+            return static_cast<const BTreeMap*>(this)->upperBound(key);
+        }
+
+        template<typename K, typename C = Compare, typename = typename C::is_transparent>
+        const_iterator upperBound(const K& key) const {
+            return boundIterator(key, true);
+        }
+
+        template<typename K, typename C = Compare, typename = typename C::is_transparent>
+        iterator upperBound(const K& key) {
+            return static_cast<const BTreeMap*>(this)->upperBound(key);
+        }
+
+        std::pair<const_iterator, const_iterator> equalRange(const key_type& key) const {
+            return std::make_pair(lowerBound(key), upperBound(key));
+        }
+
+        std::pair<iterator, iterator> equalRange(const key_type& key) {
+            return std::make_pair(lowerBound(key), upperBound(key));
+        }
+
+        template<typename K, typename C = Compare, typename = typename C::is_transparent>
+        std::pair<const_iterator, const_iterator> equalRange(const K& key) const {
+            return std::make_pair(lowerBound(key), upperBound(key));
+        }
+
+        template<typename K, typename C = Compare, typename = typename C::is_transparent>
+        std::pair<iterator, iterator> equalRange(const K& key) {
+            return std::make_pair(lowerBound(key), upperBound(key));
+        }
+        //Wywołanie pFunction dla elementów o kluczach z przedziału [lo, hi) w kolejności kluczy:
+        //jedno zejście do liścia, potem kolejne miejsca liści z listy - O(log_B n + k).
+        template<typename Function>
+        void forEachInRange(const key_type& lo, const key_type& hi, Function pFunction) const {
+            for (const_iterator it = lowerBound(lo); it != end() && mCompare(it->first, hi); ++it)
+                pFunction(*it);
+        }
+
+        template<typename Function>
+        void forEachInRange(const key_type& lo, const key_type& hi, Function pFunction) {
+            for (iterator it = lowerBound(lo); it != end() && mCompare(it->first, hi); ++it)
+                pFunction(*it);
+        }
+
+        bool operator==(const BTreeMap& other) const {
+            if (mCount != other.mCount)
+                return false;
+            //Obie mapy są uporządkowane - wystarczy porównać kolejne elementy:
+            for (auto it = begin(), otherIt = other.begin(); it != end(); ++it, ++otherIt)
+                if (it->first != otherIt->first || it->second != otherIt->second)
+                    return false;
+            return true;
+        }
+
+        bool operator!=(const BTreeMap& other) const {
+            return !(*this == other);
+        }
+
+        iterator begin() {
+            return cbegin();
+        }
+
+        iterator end() {
+            return cend();
+        }
+
+        const_iterator cbegin() const {
+            return ConstIterator(*this, mFirst, 0);
+        }
+
+        const_iterator cend() const {
+            return ConstIterator(*this, nullptr, 0);
+        }
+
+        const_iterator begin() const {
+            return cbegin();
+        }
+
+        const_iterator end() const {
+            return cend();
+        }
+
+    private:
+        //Długość prefiksu [0, pCount), na którym pBefore jest prawdziwe (wyszukiwanie binarne bez skoków -
+        //przedział zawęża się o stałą połowę, a wybór kompiluje się do cmov; w węźle rzędu 32-64 kluczy
+        //błędnie przewidziane skoki zwykłego wyszukiwania kosztują więcej niż same porównania):
+        template<typename Predicate>
+        static size_type prefixLength(size_type pCount, Predicate pBefore) {
+            if (pCount == 0)
+                return 0;
+            size_type low = 0;
+            while (pCount > 1) {
+                size_type half = pCount / 2;
+                low = pBefore(low + half) ? low + half : low;
+                pCount -= half;
+            }
+            return low + (pBefore(low) ? 1 : 0);
+        }
+
+        struct Node {
+            bool mLeaf;
+            size_type mCount;//liczba elementów (liść) albo kluczy (węzeł wewnętrzny)
+
+            explicit Node(bool pLeaf) : mLeaf(pLeaf), mCount(0) {}
+        };
+        //Liść: elementy w surowej pamięci (klucz w value_type jest stały - przenoszenie przez konstrukcję).
+        //Jedno miejsce zapasowe pozwala wstawić element przed podziałem przepełnionego liścia.
+        struct Leaf : Node {
+            using Slot = typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type;
+
+            Leaf* mPrev;
+            Leaf* mNext;
+            Slot mSlots[LeafCapacity + 1];
+
+            Leaf() : Node(true), mPrev(nullptr), mNext(nullptr) {}
+
+            ~Leaf() {
+                for (size_type i = 0; i < this->mCount; ++i)
+                    at(i)->~value_type();
+            }
+
+            value_type* at(size_type pIndex) {
+                return reinterpret_cast<value_type*>(&mSlots[pIndex]);
+            }
+            //Przeniesienie elementu do pustego miejsca:
+            void moveSlot(size_type pTo, value_type* pFrom) {
+                new (&mSlots[pTo]) value_type(std::move(*pFrom));
+                pFrom->~value_type();
+            }
+            //Pierwsze miejsce z kluczem >= pKey (pUpper: > pKey):
+            template<typename K>
+            size_type bound(const K& pKey, const Compare& pCompare, bool pUpper) {
+                if (pUpper)
+                    return prefixLength(this->mCount, [&](size_type i) { return !pCompare(pKey, at(i)->first); });
+                return prefixLength(this->mCount, [&](size_type i) { return pCompare(at(i)->first, pKey); });
+            }
+        };
+        //Węzeł wewnętrzny: dziecko i zawiera klucze z przedziału [key(i-1), key(i)).
+        //Klucze [0, mCount) są skonstruowane w surowej pamięci jak elementy liścia.
+        struct Inner : Node {
+            using Slot = typename std::aligned_storage<sizeof(key_type), alignof(key_type)>::type;
+
+            Slot mKeys[InnerCapacity + 1];
+            Node* mChildren[InnerCapacity + 2];
+
+            Inner() : Node(false) {}
+
+            ~Inner() {
+                for (size_type i = 0; i < this->mCount; ++i)
+                    key(i)->~key_type();
+            }
+
+            key_type* key(size_type pIndex) {
+                return reinterpret_cast<key_type*>(&mKeys[pIndex]);
+            }
+
+            const key_type* key(size_type pIndex) const {
+                return reinterpret_cast<const key_type*>(&mKeys[pIndex]);
+            }
+
+            template<typename K>
+            void emplaceKey(size_type pTo, K&& pKey) {
+                new (&mKeys[pTo]) key_type(std::forward<K>(pKey));
+            }
+            //Przeniesienie klucza do pustego miejsca (źródło zostaje puste):
+            void moveKey(size_type pTo, key_type* pFrom) {
+                emplaceKey(pTo, std::move(*pFrom));
+                pFrom->~key_type();
+            }
+            //Indeks dziecka, w którym może leżeć pKey:
+            template<typename K>
+            size_type childIndex(const K& pKey, const Compare& pCompare) const {
+                return prefixLength(this->mCount, [&](size_type i) { return !pCompare(pKey, *key(i)); });
+            }
+        };
+        //Klucz podziału przekazywany do rodzica - też w surowej pamięci, bo key_type nie musi mieć
+        //konstruktora domyślnego:
+        class KeyHolder {
+        public:
+            KeyHolder() : mFull(false) {}
+
+            KeyHolder(const KeyHolder&) = delete;
+            KeyHolder& operator=(const KeyHolder&) = delete;
+
+            ~KeyHolder() {
+                if (mFull)
+                    get()->~key_type();
+            }
+
+            template<typename K>
+            void set(K&& pKey) {
+                new (&mStorage) key_type(std::forward<K>(pKey));
+                mFull = true;
+            }
+
+            key_type* get() {
+                return reinterpret_cast<key_type*>(&mStorage);
+            }
+
+        private:
+            typename std::aligned_storage<sizeof(key_type), alignof(key_type)>::type mStorage;
+            bool mFull;
+        };
+
+        Node* mRoot;
+        Leaf* mFirst;//najmniejsze klucze (begin)
+        Leaf* mLast;//największe klucze (dla --end)
+        size_type mCount;
+        Compare mCompare; // porządek kluczy
+
+        static const size_type MinLeafCount = LeafCapacity / 2;
+        static const size_type MinInnerCount = InnerCapacity / 2;
+
+        void swap(BTreeMap& other) {
+            std::swap(mRoot, other.mRoot);
+            std::swap(mFirst, other.mFirst);
+            std::swap(mLast, other.mLast);
+            std::swap(mCount, other.mCount);
+            std::swap(mCompare, other.mCompare);
+        }
+        //Liść, w którym leży (albo leżałby) pKey:
+        template<typename K>
+        Leaf* leafFor(const K& pKey) const {
+            Node* node = mRoot;
+            while (!node->mLeaf)
+                node = static_cast<Inner*>(node)->mChildren[static_cast<Inner*>(node)->childIndex(pKey, mCompare)];
+            return static_cast<Leaf*>(node);
+        }
+
+        template<typename K>
+        bool findSlot(const K& pKey, Leaf*& pLeaf, size_type& pIndex) const {
+            if (mRoot == nullptr)
+                return false;
+            pLeaf = leafFor(pKey);
+            pIndex = pLeaf->bound(pKey, mCompare, false);
+            return pIndex < pLeaf->mCount && !mCompare(pKey, pLeaf->at(pIndex)->first);
+        }
+        //lowerBound/upperBound: granica może wypaść za ostatnim elementem liścia - wtedy to początek następnego:
+        template<typename K>
+        const_iterator boundIterator(const K& pKey, bool pUpper) const {
+            if (mRoot == nullptr)
+                return end();
+            Leaf* leaf = leafFor(pKey);
+            size_type index = leaf->bound(pKey, mCompare, pUpper);
+            if (index == leaf->mCount)
+                return ConstIterator(*this, leaf->mNext, 0);
+            return ConstIterator(*this, leaf, index);
+        }
+        //Wstawienie (lub odszukanie) klucza w poddrzewie; gdy węzeł się podzielił, zwraca w pRight
+        //nowy prawy węzeł, a w pSeparator jego najmniejszy klucz:
+        value_type* insert(Node* pNode, const key_type& pKey, KeyHolder& pSeparator, Node*& pRight) {
+            if (pNode->mLeaf)
+                return insertIntoLeaf(static_cast<Leaf*>(pNode), pKey, pSeparator, pRight);
+
+            Inner* inner = static_cast<Inner*>(pNode);
+            size_type index = inner->childIndex(pKey, mCompare);
+            KeyHolder separator;
+            Node* right = nullptr;
+            value_type* item = insert(inner->mChildren[index], pKey, separator, right);
+            if (right == nullptr)
+                return item;
+
+            for (size_type i = inner->mCount; i > index; --i) {
+                inner->moveKey(i, inner->key(i - 1));
+                inner->mChildren[i + 1] = inner->mChildren[i];
+            }
+            inner->emplaceKey(index, std::move(*separator.get()));
+            inner->mChildren[index + 1] = right;
+            ++inner->mCount;
+            if (inner->mCount > InnerCapacity) {//podział: środkowy klucz idzie do rodzica
+                Inner* sibling = new Inner();
+                size_type middle = inner->mCount / 2;
+                size_type count = inner->mCount - middle - 1;
+                pSeparator.set(std::move(*inner->key(middle)));
+                inner->key(middle)->~key_type();
+                for (size_type i = 0; i < count; ++i)
+                    sibling->moveKey(i, inner->key(middle + 1 + i));
+                for (size_type i = 0; i <= count; ++i)
+                    sibling->mChildren[i] = inner->mChildren[middle + 1 + i];
+                sibling->mCount = count;
+                inner->mCount = middle;
+                pRight = sibling;
+            }
+            return item;
+        }
+
+        value_type* insertIntoLeaf(Leaf* pLeaf, const key_type& pKey, KeyHolder& pSeparator, Node*& pRight) {
+            size_type index = pLeaf->bound(pKey, mCompare, false);
+            if (index < pLeaf->mCount && !mCompare(pKey, pLeaf->at(index)->first))
+                return pLeaf->at(index);
+
+            //Element powstaje przed przesunięciem - wyjątek z konstruktora klucza lub wartości zostawia liść nietknięty:
+            value_type item(pKey, mapped_type());
+            for (size_type i = pLeaf->mCount; i > index; --i)
+                pLeaf->moveSlot(i, pLeaf->at(i - 1));
+            new (&pLeaf->mSlots[index]) value_type(std::move(item));
+            ++pLeaf->mCount;
+            ++mCount;
+            if (pLeaf->mCount <= LeafCapacity)
+                return pLeaf->at(index);
+            //Przepełnienie: górna połowa do nowego liścia wpiętego w listę za pLeaf:
+            Leaf* sibling = new Leaf();
+            size_type middle = pLeaf->mCount / 2;
+            for (size_type i = middle; i < pLeaf->mCount; ++i)
+                sibling->moveSlot(i - middle, pLeaf->at(i));
+            sibling->mCount = pLeaf->mCount - middle;
+            pLeaf->mCount = middle;
+            linkAfter(pLeaf, sibling);
+            pSeparator.set(sibling->at(0)->first);
+            pRight = sibling;
+            return index < middle ? pLeaf->at(index) : sibling->at(index - middle);
+        }
+
+        void linkAfter(Leaf* pLeaf, Leaf* pNew) {
+            pNew->mPrev = pLeaf;
+            pNew->mNext = pLeaf->mNext;
+            if (pLeaf->mNext != nullptr)
+                pLeaf->mNext->mPrev = pNew;
+            else
+                mLast = pNew;
+            pLeaf->mNext = pNew;
+        }
+
+        void unlink(Leaf* pLeaf) {
+            if (pLeaf->mPrev != nullptr)
+                pLeaf->mPrev->mNext = pLeaf->mNext;
+            else
+                mFirst = pLeaf->mNext;
+            if (pLeaf->mNext != nullptr)
+                pLeaf->mNext->mPrev = pLeaf->mPrev;
+            else
+                mLast = pLeaf->mPrev;
+        }
+        //Usunięcie klucza z poddrzewa; niedopełnione dziecko jest naprawiane przez rodzica:
+        void erase(Node* pNode, const key_type& pKey) {
+            if (pNode->mLeaf) {
+                Leaf* leaf = static_cast<Leaf*>(pNode);
+                size_type index = leaf->bound(pKey, mCompare, false);
+                if (index == leaf->mCount || mCompare(pKey, leaf->at(index)->first))
+                    throw std::out_of_range("Node not found.");
+                leaf->at(index)->~value_type();
+                for (size_type i = index + 1; i < leaf->mCount; ++i)
+                    leaf->moveSlot(i - 1, leaf->at(i));
+                --leaf->mCount;
+                --mCount;
+                return;
+            }
+            Inner* inner = static_cast<Inner*>(pNode);
+            size_type index = inner->childIndex(pKey, mCompare);
+            Node* child = inner->mChildren[index];
+            erase(child, pKey);
+            if (child->mCount < (child->mLeaf ? MinLeafCount : MinInnerCount))
+                fixUnderflow(inner, index);
+        }
+        //Dziecko pIndex ma za mało elementów: pożyczenie od rodzeństwa albo scalenie:
+        void fixUnderflow(Inner* pParent, size_type pIndex) {
+            Node* child = pParent->mChildren[pIndex];
+            Node* left = pIndex > 0 ? pParent->mChildren[pIndex - 1] : nullptr;
+            Node* right = pIndex < pParent->mCount ? pParent->mChildren[pIndex + 1] : nullptr;
+            size_type minimum = child->mLeaf ? MinLeafCount : MinInnerCount;
+
+            if (left != nullptr && left->mCount > minimum)
+                borrowFromLeft(pParent, pIndex);
+            else if (right != nullptr && right->mCount > minimum)
+                borrowFromRight(pParent, pIndex);
+            else if (left != nullptr)
+                merge(pParent, pIndex - 1);
+            else if (right != nullptr)
+                merge(pParent, pIndex);
+        }
+
+        void borrowFromLeft(Inner* pParent, size_type pIndex) {
+            Node* node = pParent->mChildren[pIndex];
+            Node* sibling = pParent->mChildren[pIndex - 1];
+            if (node->mLeaf) {
+                Leaf* leaf = static_cast<Leaf*>(node);
+                Leaf* from = static_cast<Leaf*>(sibling);
+                for (size_type i = leaf->mCount; i > 0; --i)
+                    leaf->moveSlot(i, leaf->at(i - 1));
+                leaf->moveSlot(0, from->at(from->mCount - 1));
+                replaceKey(pParent, pIndex - 1, leaf->at(0)->first);
+            } else {
+                Inner* inner = static_cast<Inner*>(node);
+                Inner* from = static_cast<Inner*>(sibling);
+                for (size_type i = inner->mCount; i > 0; --i)
+                    inner->moveKey(i, inner->key(i - 1));
+                for (size_type i = inner->mCount + 1; i > 0; --i)
+                    inner->mChildren[i] = inner->mChildren[i - 1];
+                inner->moveKey(0, pParent->key(pIndex - 1));
+                inner->mChildren[0] = from->mChildren[from->mCount];
+                pParent->moveKey(pIndex - 1, from->key(from->mCount - 1));
+            }
+            ++node->mCount;
+            --sibling->mCount;
+        }
+
+        void borrowFromRight(Inner* pParent, size_type pIndex) {
+            Node* node = pParent->mChildren[pIndex];
+            Node* sibling = pParent->mChildren[pIndex + 1];
+            if (node->mLeaf) {
+                Leaf* leaf = static_cast<Leaf*>(node);
+                Leaf* from = static_cast<Leaf*>(sibling);
+                leaf->moveSlot(leaf->mCount, from->at(0));
+                for (size_type i = 1; i < from->mCount; ++i)
+                    from->moveSlot(i - 1, from->at(i));
+                replaceKey(pParent, pIndex, from->at(0)->first);
+            } else {
+                Inner* inner = static_cast<Inner*>(node);
+                Inner* from = static_cast<Inner*>(sibling);
+                inner->moveKey(inner->mCount, pParent->key(pIndex));
+                inner->mChildren[inner->mCount + 1] = from->mChildren[0];
+                pParent->moveKey(pIndex, from->key(0));
+                for (size_type i = 1; i < from->mCount; ++i)
+                    from->moveKey(i - 1, from->key(i));
+                for (size_type i = 1; i <= from->mCount; ++i)
+                    from->mChildren[i - 1] = from->mChildren[i];
+            }
+            ++node->mCount;
+            --sibling->mCount;
+        }
+        //Nowy separator w rodzicu po pożyczeniu elementu liścia (kopia powstaje przed zniszczeniem starego):
+        static void replaceKey(Inner* pParent, size_type pIndex, const key_type& pKey) {
+            key_type copy(pKey);
+            pParent->key(pIndex)->~key_type();
+            pParent->emplaceKey(pIndex, std::move(copy));
+        }
+        //Scalenie dzieci pIndex i pIndex + 1 w lewe; separator znika z rodzica:
+        void merge(Inner* pParent, size_type pIndex) {
+            Node* left = pParent->mChildren[pIndex];
+            Node* right = pParent->mChildren[pIndex + 1];
+            if (left->mLeaf) {
+                Leaf* to = static_cast<Leaf*>(left);
+                Leaf* from = static_cast<Leaf*>(right);
+                for (size_type i = 0; i < from->mCount; ++i)
+                    to->moveSlot(to->mCount + i, from->at(i));
+                to->mCount += from->mCount;
+                from->mCount = 0;
+                unlink(from);
+                delete from;
+                pParent->key(pIndex)->~key_type();
+            } else {
+                Inner* to = static_cast<Inner*>(left);
+                Inner* from = static_cast<Inner*>(right);
+                to->moveKey(to->mCount, pParent->key(pIndex));
+                for (size_type i = 0; i < from->mCount; ++i)
+                    to->moveKey(to->mCount + 1 + i, from->key(i));
+                for (size_type i = 0; i <= from->mCount; ++i)
+                    to->mChildren[to->mCount + 1 + i] = from->mChildren[i];
+                to->mCount += from->mCount + 1;
+                from->mCount = 0;
+                delete from;
+            }
+            //Miejsce separatora pIndex jest już puste:
+            for (size_type i = pIndex + 1; i < pParent->mCount; ++i) {
+                pParent->moveKey(i - 1, pParent->key(i));
+                pParent->mChildren[i] = pParent->mChildren[i + 1];
+            }
+            --pParent->mCount;
+        }
+
+        void clear() {
+            if (mRoot != nullptr)
+                destroy(mRoot);
+            mRoot = mFirst = mLast = nullptr;
+            mCount = 0;
+        }
+        //Rekurencja ma głębokość równą wysokości drzewa (kilka poziomów):
+        void destroy(Node* pNode) {
+            if (pNode->mLeaf) {
+                delete static_cast<Leaf*>(pNode);
+                return;
+            }
+            Inner* inner = static_cast<Inner*>(pNode);
+            for (size_type i = 0; i <= inner->mCount; ++i)
+                destroy(inner->mChildren[i]);
+            delete inner;
+        }
+    };
+
+    template<typename KeyType, typename ValueType, typename Compare>
+    const typename BTreeMap<KeyType, ValueType, Compare>::size_type BTreeMap<KeyType, ValueType, Compare>::LeafCapacity;
+
+    template<typename KeyType, typename ValueType, typename Compare>
+    const typename BTreeMap<KeyType, ValueType, Compare>::size_type BTreeMap<KeyType, ValueType, Compare>::InnerCapacity;
+
+    template<typename KeyType, typename ValueType, typename Compare>
+    const typename BTreeMap<KeyType, ValueType, Compare>::size_type BTreeMap<KeyType, ValueType, Compare>::MinLeafCount;
+
+    template<typename KeyType, typename ValueType, typename Compare>
+    const typename BTreeMap<KeyType, ValueType, Compare>::size_type BTreeMap<KeyType, ValueType, Compare>::MinInnerCount;
+
+    template<typename KeyType, typename ValueType, typename Compare>
+    class BTreeMap<KeyType, ValueType, Compare>::ConstIterator {
+    public:
+        using reference = typename BTreeMap::const_reference;
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = typename BTreeMap::value_type;
+        using pointer = const typename BTreeMap::value_type*;
+
+        friend class BTreeMap;
+
+        //Pozycja to liść i indeks w nim; end() to liść nullptr:
+        explicit ConstIterator(const BTreeMap& pMap, Leaf* pLeaf, size_type pIndex) : mMap(&pMap), mLeaf(pLeaf),
+                                                                                    mIndex(pIndex) {}
+
+        ConstIterator& operator++() {
+            if (mLeaf == nullptr)
+                throw std::out_of_range("End of tree.");
+            if (++mIndex == mLeaf->mCount) {
+                mLeaf = mLeaf->mNext;
+                mIndex = 0;
+            }
+            return *this;
+        }
+
+        ConstIterator operator++(int) {
+            ConstIterator temp(*this);
+            operator++();
+            return temp;
+        }
+
+        ConstIterator& operator--() {
+            if (mLeaf == nullptr) {
+                if (mMap->mLast == nullptr)
+                    throw std::out_of_range("At the beginning.");
+                mLeaf = mMap->mLast;
+                mIndex = mLeaf->mCount - 1;
+            } else if (mIndex > 0) {
+                --mIndex;
+            } else {
+                if (mLeaf->mPrev == nullptr)
+                    throw std::out_of_range("At the beginning.");
+                mLeaf = mLeaf->mPrev;
+                mIndex = mLeaf->mCount - 1;
+            }
+            return *this;
+        }
+
+        ConstIterator operator--(int) {
+            ConstIterator temp(*this);
+            operator--();
+            return temp;
+        }
+
+        reference operator*() const {
+            if (mLeaf == nullptr)
+                throw std::out_of_range("Dereferencing end iterator");
+            return *mLeaf->at(mIndex);
+        }
+
+        pointer operator->() const {
+            return &this->operator*();
+        }
+
+        bool operator==(const ConstIterator& other) const {
+            return mLeaf == other.mLeaf && mIndex == other.mIndex;
+        }
+
+        bool operator!=(const ConstIterator& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        const BTreeMap* mMap;
+        Leaf* mLeaf; // liść z elementem (nullptr dla end)
+        size_type mIndex; // pozycja w liściu
+    };
+
+    template<typename KeyType, typename ValueType, typename Compare>
+    class BTreeMap<KeyType, ValueType, Compare>::Iterator : public BTreeMap<KeyType, ValueType, Compare>::ConstIterator {
+    public:
+        using reference = typename BTreeMap::reference;
+        using pointer = typename BTreeMap::value_type*;
+
+        explicit Iterator(const BTreeMap& pMap, Leaf* pLeaf, size_type pIndex) : ConstIterator(pMap, pLeaf, pIndex) {}
+
+        Iterator(const ConstIterator& other)
+                : ConstIterator(other) {}
+
+        Iterator& operator++() {
+            ConstIterator::operator++();
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            auto result = *this;
+            ConstIterator::operator++();
+            return result;
+        }
+
+        Iterator& operator--() {
+            ConstIterator::operator--();
+            return *this;
+        }
+
+        Iterator operator--(int) {
+            auto result = *this;
+            ConstIterator::operator--();
+            return result;
+        }
+
+        pointer operator->() const {
+            return &this->operator*();
+        }
+
+        reference operator*() const {
+            // ugly cast, yet reduces code duplication.
+            return const_cast<reference>(ConstIterator::operator*());
+        }
+    };
+
+}
+
+#endif /* AISDI_MAPS_BTREEMAP_H */
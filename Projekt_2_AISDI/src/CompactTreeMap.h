@@ -0,0 +1,646 @@
+#ifndef AISDI_MAPS_COMPACTTREEMAP_H
+#define AISDI_MAPS_COMPACTTREEMAP_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace aisdi {
+
+    //Zwarta odmiana TreeMap (AVL) dla dużych map o małych elementach. Węzły leżą w arenie bloków stałego
+    //rozmiaru i wskazują się 32-bitowymi indeksami zamiast wskaźników; wysokość węzła zajmuje wolne
+    //najstarsze bity indeksów dzieci. Dla <int, int> węzeł ma 20 B zamiast 40 B (3 wskaźniki i int)
+    //w pierwotnym TreeMap i 56 B w obecnym. W zamian nie ma listy następników (++ iteratora wspina się
+    //po rodzicach - zamortyzowane O(1)), rozmiarów poddrzew, agregatów ani split/join.
+    //Indeksy mają 29 bitów, więc mapa mieści co najwyżej 2^29 - 1 elementów.
+    template<typename KeyType, typename ValueType, typename Compare = std::less<KeyType>>
+    class CompactTreeMap {
+    public:
+        using key_type = KeyType;
+        using key_compare = Compare;
+        using mapped_type = ValueType;
+        using value_type = std::pair<const key_type, mapped_type>;
+        using size_type = std::size_t;
+        using reference = value_type&;
+        using const_reference = const value_type&;
+
+        class ConstIterator;
+
+        class Iterator;
+
+        using iterator = Iterator;
+        using const_iterator = ConstIterator;
+
+        CompactTreeMap() : CompactTreeMap(Compare()) {}
+
+        explicit CompactTreeMap(const Compare& pCompare) : mRoot(NoNode), mUsed(1), mCount(0),
+                                                           mCompare(pCompare) {}
+
+        CompactTreeMap(std::initializer_list<value_type> list) : CompactTreeMap() {
+            for (auto&& item : list)
+                (*this)[item.first] = item.second;
+        }
+
+        //Kopia przez sklonowanie struktury (wysokości bez zmian) - O(n), bez rotacji:
+        CompactTreeMap(const CompactTreeMap& other) : CompactTreeMap(other.mCompare) {
+            copyFrom(other);
+        }
+
+        CompactTreeMap(CompactTreeMap&& other) : CompactTreeMap(other.mCompare) {
+            swap(other);
+        }
+
+        ~CompactTreeMap() {
+            clear();
+        }
+
+        CompactTreeMap& operator=(const CompactTreeMap& other) {
+            if (this == &other)
+                return *this;
+            clear();
+            mCompare = other.mCompare;
+            copyFrom(other);
+            return *this;
+        }
+
+        CompactTreeMap& operator=(CompactTreeMap&& other) {
+            if (this == &other)
+                return *this;
+            clear();
+            swap(other);
+            return *this;
+        }
+
+        bool isEmpty() const {
+            return mCount == 0;
+        }
+
+        mapped_type& operator[](const key_type& key) {
+            std::uint32_t parent = NoNode;
+            std::uint32_t node = mRoot;
+            while (node != NoNode) {
+                if (mCompare(key, at(node).mPair.first)) {
+                    parent = node;
+                    node = left(node);
+                } else if (mCompare(at(node).mPair.first, key)) {
+                    parent = node;
+                    node = right(node);
+                } else {
+                    return at(node).mPair.second;
+                }
+            }
+            return at(attach(key, parent)).mPair.second;
+        }
+
+        const mapped_type& valueOf(const key_type& key) const {
+            std::uint32_t node = findNode(key);
+            if (node == NoNode)
+                throw std::out_of_range("Key not found.");
+            return at(node).mPair.second;
+        }
+
+        mapped_type& valueOf(const key_type& key) {
+            return const_cast<mapped_type&>(static_cast<const CompactTreeMap*>(this)->valueOf(key));
+        }
+
+        const_iterator find(const key_type& key) const {
+            return ConstIterator(*this, findNode(key));
+        }
+
+        iterator find(const key_type& key) {
+            return static_cast<const CompactTreeMap*>(this)->find(key);
+        }
+
+        void remove(const key_type& key) {
+            std::uint32_t node = findNode(key);
+            if (node == NoNode)
+                throw std::out_of_range("Node not found.");
+            removeNode(node);
+        }
+
+        void remove(const const_iterator& it) {
+            if (it == end())
+                throw std::out_of_range("Removing end iterator");
+            removeNode(it.mNode);
+        }
+
+        size_type getSize() const {
+            return mCount;
+        }
+        //Pierwszy element o kluczu >= key (end, gdy brak):
+        const_iterator lowerBound(const key_type& key) const {
+            return ConstIterator(*this, boundNode(key, false));
+        }
+
+        iterator lowerBound(const key_type& key) {
+            return static_cast<const CompactTreeMap*>(this)->lowerBound(key);
+        }
+        //Pierwszy element o kluczu > key (end, gdy brak):
+        const_iterator upperBound(const key_type& key) const {
+            return ConstIterator(*this, boundNode(key, true));
+        }
+
+        iterator upperBound(const key_type& key) {
+            return static_cast<const CompactTreeMap*>(this)->upperBound(key);
+        }
+
+        bool operator==(const CompactTreeMap& other) const {
+            if (mCount != other.mCount)
+                return false;
+            //Obie mapy są uporządkowane - wystarczy porównać kolejne elementy:
+            for (auto it = begin(), otherIt = other.begin(); it != end(); ++it, ++otherIt)
+                if (it->first != otherIt->first || it->second != otherIt->second)
+                    return false;
+            return true;
+        }
+
+        bool operator!=(const CompactTreeMap& other) const {
+            return !(*this == other);
+        }
+
+        iterator begin() {
+            return cbegin();
+        }
+
+        iterator end() {
+            return cend();
+        }
+
+        const_iterator cbegin() const {
+            return ConstIterator(*this, mRoot == NoNode ? NoNode : minimum(mRoot));
+        }
+
+        const_iterator cend() const {
+            return ConstIterator(*this, NoNode);
+        }
+
+        const_iterator begin() const {
+            return cbegin();
+        }
+
+        const_iterator end() const {
+            return cend();
+        }
+
+    private:
+        struct Node {
+            value_type mPair;//para klucz porządkujący/wartość
+            std::uint32_t mParent;//indeks rodzica (NoNode dla korzenia)
+            std::uint32_t mLeft;//indeks lewego dziecka; 3 najstarsze bity - starsza połowa wysokości
+            std::uint32_t mRight;//indeks prawego dziecka; 3 najstarsze bity - młodsza połowa wysokości
+
+            Node(const value_type& pPair, std::uint32_t pParent) : mPair(pPair), mParent(pParent), mLeft(NoNode),
+                                                                   mRight(NoNode) {}
+        };
+
+        using Slot = typename std::aligned_storage<sizeof(Node), alignof(Node)>::type;
+
+        static const std::uint32_t NoNode = 0;//indeks 0 nie jest nigdy przydzielany
+        static const unsigned IndexBits = 29;
+        static const std::uint32_t IndexMask = (std::uint32_t(1) << IndexBits) - 1;
+        static const size_type MaxSize = IndexMask;
+        //Bloki areny mają stały rozmiar, więc indeks wyznacza blok i miejsce bez szukania, a węzły
+        //nigdy nie są przenoszone (przenoszenie surowej pamięci psułoby np. std::string):
+        static const unsigned ChunkBits = 10;
+        static const std::uint32_t ChunkMask = (std::uint32_t(1) << ChunkBits) - 1;
+
+        std::uint32_t mRoot;
+        std::uint32_t mUsed;//liczba kiedykolwiek przydzielonych indeksów (z nieużywanym 0)
+        size_type mCount;
+        Compare mCompare; // porządek kluczy
+        std::vector<std::unique_ptr<Slot[]>> mChunks;
+        std::vector<std::uint32_t> mFree;//indeksy usuniętych węzłów do ponownego użycia
+
+        void swap(CompactTreeMap& other) {
+            std::swap(mRoot, other.mRoot);
+            std::swap(mUsed, other.mUsed);
+            std::swap(mCount, other.mCount);
+            std::swap(mCompare, other.mCompare);
+            mChunks.swap(other.mChunks);
+            mFree.swap(other.mFree);
+        }
+
+        Node& at(std::uint32_t pIndex) const {
+            return *reinterpret_cast<Node*>(&mChunks[pIndex >> ChunkBits][pIndex & ChunkMask]);
+        }
+
+        std::uint32_t parent(std::uint32_t pIndex) const {
+            return at(pIndex).mParent;
+        }
+
+        std::uint32_t left(std::uint32_t pIndex) const {
+            return at(pIndex).mLeft & IndexMask;
+        }
+
+        std::uint32_t right(std::uint32_t pIndex) const {
+            return at(pIndex).mRight & IndexMask;
+        }
+        //Wysokość (liść ma 1, brak węzła 0) - AVL o 2^29 węzłach ma wysokość < 44, więc wystarcza 6 bitów:
+        int height(std::uint32_t pIndex) const {
+            if (pIndex == NoNode)
+                return 0;
+            const Node& node = at(pIndex);
+            return static_cast<int>((node.mLeft >> IndexBits) << 3 | node.mRight >> IndexBits);
+        }
+
+        void setLeft(std::uint32_t pIndex, std::uint32_t pChild) {
+            Node& node = at(pIndex);
+            node.mLeft = (node.mLeft & ~IndexMask) | pChild;
+            if (pChild != NoNode)
+                at(pChild).mParent = pIndex;
+        }
+
+        void setRight(std::uint32_t pIndex, std::uint32_t pChild) {
+            Node& node = at(pIndex);
+            node.mRight = (node.mRight & ~IndexMask) | pChild;
+            if (pChild != NoNode)
+                at(pChild).mParent = pIndex;
+        }
+
+        void setHeight(std::uint32_t pIndex, int pHeight) {
+            Node& node = at(pIndex);
+            std::uint32_t height = static_cast<std::uint32_t>(pHeight);
+            node.mLeft = (node.mLeft & IndexMask) | (height >> 3) << IndexBits;
+            node.mRight = (node.mRight & IndexMask) | (height & 7) << IndexBits;
+        }
+        //Nowy węzeł w wolnym miejscu areny; indeks jest zajmowany dopiero po udanej konstrukcji pary:
+        std::uint32_t createNode(const value_type& pPair, std::uint32_t pParent) {
+            if (mCount == MaxSize)
+                throw std::length_error("Too many elements.");
+            std::uint32_t index = mFree.empty() ? mUsed : mFree.back();
+            if ((index >> ChunkBits) == mChunks.size())
+                mChunks.emplace_back(new Slot[ChunkMask + 1]);
+            new (&at(index)) Node(pPair, pParent);
+            if (mFree.empty())
+                ++mUsed;
+            else
+                mFree.pop_back();
+            setHeight(index, 1);
+            return index;
+        }
+
+        //Wstawienie nowego węzła jako dziecka pParent (miejsce wyznaczone przez przejście w operator[]):
+        std::uint32_t attach(const key_type& pKey, std::uint32_t pParent) {
+            std::uint32_t node = createNode(value_type(pKey, mapped_type()), pParent);
+            ++mCount;
+            if (pParent == NoNode)
+                mRoot = node;
+            else if (mCompare(pKey, at(pParent).mPair.first))
+                setLeft(pParent, node);
+            else
+                setRight(pParent, node);
+            rebalance(pParent);
+            return node;
+        }
+        //Usuwanie węzła; klucze są stałe, więc węzeł z dwojgiem dzieci zastępuje następnik (przepięcie indeksów):
+        void removeNode(std::uint32_t pNode) {
+            mFree.push_back(pNode);//jedyna alokacja - zanim drzewo zostanie zmienione
+            std::uint32_t retraceFrom;//najniższy węzeł, którego poddrzewo straciło element
+            if (left(pNode) != NoNode && right(pNode) != NoNode) {
+                std::uint32_t successor = minimum(right(pNode));
+                if (parent(successor) == pNode) {
+                    retraceFrom = successor;
+                } else {
+                    retraceFrom = parent(successor);
+                    replaceChild(successor, right(successor));
+                    setRight(successor, right(pNode));
+                }
+                setLeft(successor, left(pNode));
+                setHeight(successor, height(pNode));
+                replaceChild(pNode, successor);
+            } else {
+                retraceFrom = parent(pNode);
+                replaceChild(pNode, left(pNode) != NoNode ? left(pNode) : right(pNode));
+            }
+            at(pNode).~Node();
+            --mCount;
+            rebalance(retraceFrom);//wyrównanie drzewa
+        }
+        //Podpięcie pChild (może być NoNode) w miejsce pNode u jego rodzica:
+        void replaceChild(std::uint32_t pNode, std::uint32_t pChild) {
+            std::uint32_t up = parent(pNode);
+            if (up == NoNode) {
+                mRoot = pChild;
+                if (pChild != NoNode)
+                    at(pChild).mParent = NoNode;
+            } else if (left(up) == pNode) {
+                setLeft(up, pChild);
+            } else {
+                setRight(up, pChild);
+            }
+        }
+
+        std::uint32_t findNode(const key_type& pKey) const {
+            std::uint32_t node = mRoot;
+            while (node != NoNode) {
+                if (mCompare(pKey, at(node).mPair.first))
+                    node = left(node);
+                else if (mCompare(at(node).mPair.first, pKey))
+                    node = right(node);
+                else
+                    return node;
+            }
+            return NoNode;
+        }
+        //Najmniejszy węzeł o kluczu >= pKey (pUpper: > pKey):
+        std::uint32_t boundNode(const key_type& pKey, bool pUpper) const {
+            std::uint32_t result = NoNode;
+            for (std::uint32_t node = mRoot; node != NoNode;) {
+                const key_type& key = at(node).mPair.first;
+                if (pUpper ? mCompare(pKey, key) : !mCompare(key, pKey)) {
+                    result = node;
+                    node = left(node);
+                } else {
+                    node = right(node);
+                }
+            }
+            return result;
+        }
+
+        std::uint32_t minimum(std::uint32_t pNode) const {
+            while (left(pNode) != NoNode)
+                pNode = left(pNode);
+            return pNode;
+        }
+
+        std::uint32_t maximum(std::uint32_t pNode) const {
+            while (right(pNode) != NoNode)
+                pNode = right(pNode);
+            return pNode;
+        }
+        //Następnik bez listy elementów: najmniejszy w prawym poddrzewie albo pierwszy przodek z lewej strony:
+        std::uint32_t successor(std::uint32_t pNode) const {
+            if (right(pNode) != NoNode)
+                return minimum(right(pNode));
+            std::uint32_t up = parent(pNode);
+            while (up != NoNode && right(up) == pNode) {
+                pNode = up;
+                up = parent(up);
+            }
+            return up;
+        }
+
+        std::uint32_t predecessor(std::uint32_t pNode) const {
+            if (left(pNode) != NoNode)
+                return maximum(left(pNode));
+            std::uint32_t up = parent(pNode);
+            while (up != NoNode && left(up) == pNode) {
+                pNode = up;
+                up = parent(up);
+            }
+            return up;
+        }
+        //Wyrównanie drzewa po wstawieniu/usunięciu: wędrówka w górę od pNode, kończona,
+        //gdy wysokość poddrzewa się nie zmieniła - wyżej nic się nie zmienia:
+        void rebalance(std::uint32_t pNode) {
+            while (pNode != NoNode) {
+                int oldHeight = height(pNode);
+                pNode = balance(pNode);
+                if (parent(pNode) == NoNode)
+                    mRoot = pNode;
+                if (height(pNode) == oldHeight)
+                    break;
+                pNode = parent(pNode);
+            }
+        }
+        //Aktualizacja wysokości i ewentualna rotacja w jednym węźle, zwraca nowy korzeń poddrzewa:
+        std::uint32_t balance(std::uint32_t pRoot) {
+            update(pRoot);
+
+            int balance = height(right(pRoot)) - height(left(pRoot));
+            //Gdy wysokość większa po stronie lewej:
+            if (balance == -2) {
+                if (height(right(left(pRoot))) - height(left(left(pRoot))) > 0)
+                    rotateLeft(left(pRoot));
+                pRoot = rotateRight(pRoot);
+            //Po stronie prawej
+            } else if (balance == 2) {
+                if (height(right(right(pRoot))) - height(left(right(pRoot))) < 0)
+                    rotateRight(right(pRoot));
+                pRoot = rotateLeft(pRoot);
+            }
+            return pRoot;
+        }
+
+        void update(std::uint32_t pNode) {
+            setHeight(pNode, 1 + std::max(height(left(pNode)), height(right(pNode))));
+        }
+        //Rotacje zwracają nowy korzeń poddrzewa (podpięty już w miejsce starego):
+        std::uint32_t rotateLeft(std::uint32_t pRoot) {
+            std::uint32_t pivot = right(pRoot);
+            std::uint32_t up = parent(pRoot);
+            bool wasLeft = up != NoNode && left(up) == pRoot;
+            setRight(pRoot, left(pivot));
+            setLeft(pivot, pRoot);
+            reattach(up, wasLeft, pivot);
+            update(pRoot);
+            update(pivot);
+            return pivot;
+        }
+
+        std::uint32_t rotateRight(std::uint32_t pRoot) {
+            std::uint32_t pivot = left(pRoot);
+            std::uint32_t up = parent(pRoot);
+            bool wasLeft = up != NoNode && left(up) == pRoot;
+            setLeft(pRoot, right(pivot));
+            setRight(pivot, pRoot);
+            reattach(up, wasLeft, pivot);
+            update(pRoot);
+            update(pivot);
+            return pivot;
+        }
+
+        void reattach(std::uint32_t pParent, bool pLeft, std::uint32_t pChild) {
+            if (pParent == NoNode) {
+                at(pChild).mParent = NoNode;
+                mRoot = pChild;
+            } else if (pLeft) {
+                setLeft(pParent, pChild);
+            } else {
+                setRight(pParent, pChild);
+            }
+        }
+        //Kopia pustej mapy; wyjątek zostawia ją pustą (już sklonowana część jest zawsze podpięta do drzewa):
+        void copyFrom(const CompactTreeMap& pOther) {
+            try {
+                clone(pOther, pOther.mRoot, NoNode, false);
+            } catch (...) {
+                clear();
+                throw;
+            }
+            mCount = pOther.mCount;
+        }
+        //Klon poddrzewa pNode mapy pOther jako dziecka pParent (rekurencja ma głębokość równą wysokości drzewa):
+        void clone(const CompactTreeMap& pOther, std::uint32_t pNode, std::uint32_t pParent, bool pLeft) {
+            if (pNode == NoNode)
+                return;
+            std::uint32_t node = createNode(pOther.at(pNode).mPair, pParent);
+            setHeight(node, pOther.height(pNode));
+            reattach(pParent, pLeft, node);
+            clone(pOther, pOther.left(pNode), node, true);
+            clone(pOther, pOther.right(pNode), node, false);
+        }
+
+        void clear() {
+            if (!std::is_trivially_destructible<value_type>::value && mRoot != NoNode)
+                destroy(mRoot);
+            mChunks.clear();
+            mFree.clear();
+            mRoot = NoNode;
+            mUsed = 1;
+            mCount = 0;
+        }
+
+        void destroy(std::uint32_t pNode) {
+            if (pNode == NoNode)
+                return;
+            destroy(left(pNode));
+            destroy(right(pNode));
+            at(pNode).~Node();
+        }
+    };
+
+    template<typename KeyType, typename ValueType, typename Compare>
+    const std::uint32_t CompactTreeMap<KeyType, ValueType, Compare>::NoNode;
+
+    template<typename KeyType, typename ValueType, typename Compare>
+    const unsigned CompactTreeMap<KeyType, ValueType, Compare>::IndexBits;
+
+    template<typename KeyType, typename ValueType, typename Compare>
+    const std::uint32_t CompactTreeMap<KeyType, ValueType, Compare>::IndexMask;
+
+    template<typename KeyType, typename ValueType, typename Compare>
+    const typename CompactTreeMap<KeyType, ValueType, Compare>::size_type
+            CompactTreeMap<KeyType, ValueType, Compare>::MaxSize;
+
+    template<typename KeyType, typename ValueType, typename Compare>
+    const unsigned CompactTreeMap<KeyType, ValueType, Compare>::ChunkBits;
+
+    template<typename KeyType, typename ValueType, typename Compare>
+    const std::uint32_t CompactTreeMap<KeyType, ValueType, Compare>::ChunkMask;
+
+    template<typename KeyType, typename ValueType, typename Compare>
+    class CompactTreeMap<KeyType, ValueType, Compare>::ConstIterator {
+    public:
+        using reference = typename CompactTreeMap::const_reference;
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = typename CompactTreeMap::value_type;
+        using pointer = const typename CompactTreeMap::value_type*;
+
+        friend class CompactTreeMap;
+
+        //Pozycja to indeks węzła; end() to NoNode:
+        explicit ConstIterator(const CompactTreeMap& pMap, std::uint32_t pNode) : mMap(&pMap), mNode(pNode) {}
+
+        ConstIterator& operator++() {
+            if (mNode == NoNode)
+                throw std::out_of_range("End of tree.");
+            mNode = mMap->successor(mNode);
+            return *this;
+        }
+
+        ConstIterator operator++(int) {
+            ConstIterator temp(*this);
+            operator++();
+            return temp;
+        }
+
+        ConstIterator& operator--() {
+            if (mNode == NoNode) {
+                if (mMap->mRoot == NoNode)
+                    throw std::out_of_range("At the beginning.");
+                mNode = mMap->maximum(mMap->mRoot);
+                return *this;
+            }
+            std::uint32_t previous = mMap->predecessor(mNode);
+            if (previous == NoNode)
+                throw std::out_of_range("At the beginning.");
+            mNode = previous;
+            return *this;
+        }
+
+        ConstIterator operator--(int) {
+            ConstIterator temp(*this);
+            operator--();
+            return temp;
+        }
+
+        reference operator*() const {
+            if (mNode == NoNode)
+                throw std::out_of_range("Dereferencing end iterator");
+            return mMap->at(mNode).mPair;
+        }
+
+        pointer operator->() const {
+            return &this->operator*();
+        }
+
+        bool operator==(const ConstIterator& other) const {
+            return mNode == other.mNode;
+        }
+
+        bool operator!=(const ConstIterator& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        const CompactTreeMap* mMap;
+        std::uint32_t mNode; // indeks węzła (NoNode dla end)
+    };
+
+    template<typename KeyType, typename ValueType, typename Compare>
+    class CompactTreeMap<KeyType, ValueType, Compare>::Iterator
+            : public CompactTreeMap<KeyType, ValueType, Compare>::ConstIterator {
+    public:
+        using reference = typename CompactTreeMap::reference;
+        using pointer = typename CompactTreeMap::value_type*;
+
+        explicit Iterator(const CompactTreeMap& pMap, std::uint32_t pNode) : ConstIterator(pMap, pNode) {}
+
+        Iterator(const ConstIterator& other)
+                : ConstIterator(other) {}
+
+        Iterator& operator++() {
+            ConstIterator::operator++();
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            auto result = *this;
+            ConstIterator::operator++();
+            return result;
+        }
+
+        Iterator& operator--() {
+            ConstIterator::operator--();
+            return *this;
+        }
+
+        Iterator operator--(int) {
+            auto result = *this;
+            ConstIterator::operator--();
+            return result;
+        }
+
+        pointer operator->() const {
+            return &this->operator*();
+        }
+
+        reference operator*() const {
+            // ugly cast, yet reduces code duplication.
+            return const_cast<reference>(ConstIterator::operator*());
+        }
+    };
+
+}
+
+#endif /* AISDI_MAPS_COMPACTTREEMAP_H */
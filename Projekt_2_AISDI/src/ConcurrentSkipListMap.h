@@ -0,0 +1,426 @@
+#ifndef AISDI_MAPS_CONCURRENTSKIPLISTMAP_H
+#define AISDI_MAPS_CONCURRENTSKIPLISTMAP_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace aisdi {
+
+    //Współbieżna mapa uporządkowana - "leniwa" lista z przeskokami (Herlihy, Lev, Luchangco, Shavit).
+    //Odczyty (find, forEachInRange) nie biorą blokad list: idą po atomowych wskaźnikach i na końcu
+    //sprawdzają flagi węzła (w pełni dołączony, nieusunięty). Zmiany blokują tylko poprzedników na
+    //poziomach węzła, sprawdzają, czy nic się między nimi nie zmieniło, a w razie konfliktu ponawiają.
+    //Klucz węzła jest niezmienny; wartość jest czytana i zapisywana pod blokadą węzła (kopia), więc
+    //typy wartości nie muszą być atomowe. Usunięte węzły mogą jeszcze być czytane przez trwające
+    //operacje, dlatego zwalnianie odbywa się epokami: operacja jest liczona w liczniku parzystości
+    //epoki, w której się zaczęła, a odpięty węzeł trafia na listę epoki usunięcia. remove() przesuwa
+    //epokę, gdy skończyły się operacje sprzed dwóch epok, i zwalnia wtedy węzły usunięte dwie epoki
+    //wcześniej. Zaległe węzły są więc ograniczone liczbą usunięć w czasie najdłuższej trwającej
+    //operacji (np. długiego forEachInRange), a nie łączną liczbą usunięć.
+    template<typename KeyType, typename ValueType, typename Compare = std::less<KeyType>>
+    class ConcurrentSkipListMap {
+    public:
+        using key_type = KeyType;
+        using key_compare = Compare;
+        using mapped_type = ValueType;
+        using value_type = std::pair<const key_type, mapped_type>;
+        using size_type = std::size_t;
+
+        ConcurrentSkipListMap() : ConcurrentSkipListMap(Compare()) {}
+
+        explicit ConcurrentSkipListMap(const Compare& pCompare) : mHead(createTower(MaxLevel)), mLevel(1), mCount(0),
+                                                                  mEpoch(0), mCompare(pCompare) {
+            mActive[0].store(0, std::memory_order_relaxed);
+            mActive[1].store(0, std::memory_order_relaxed);
+        }
+
+        ConcurrentSkipListMap(const ConcurrentSkipListMap&) = delete;
+        ConcurrentSkipListMap& operator=(const ConcurrentSkipListMap&) = delete;
+
+        ~ConcurrentSkipListMap() {
+            Tower* tower = mHead->next(0).load(std::memory_order_relaxed);
+            while (tower != nullptr) {
+                Tower* next = tower->next(0).load(std::memory_order_relaxed);
+                destroyNode(static_cast<Node*>(tower));
+                tower = next;
+            }
+            for (auto& retired : mRetired)
+                for (Node* node : retired)
+                    destroyNode(node);
+            destroyTower(mHead);
+        }
+
+        bool isEmpty() const {
+            return getSize() == 0;
+        }
+        //Przy trwających zmianach - wartość z chwili odczytu:
+        size_type getSize() const {
+            return mCount.load(std::memory_order_relaxed);
+        }
+        //Kopia wartości dla key; false, gdy klucza nie ma:
+        bool find(const key_type& key, mapped_type& value) const {
+            ActiveGuard active(*this);
+            Tower* pred = mHead;
+            Tower* curr = nullptr;
+            for (int level = mLevel.load(std::memory_order_acquire) - 1; level >= 0; --level) {
+                curr = pred->next(level).load(std::memory_order_acquire);
+                while (curr != nullptr && mCompare(keyOf(curr), key)) {
+                    pred = curr;
+                    curr = pred->next(level).load(std::memory_order_acquire);
+                }
+            }
+            if (curr == nullptr || mCompare(key, keyOf(curr)) || !isLive(curr))
+                return false;
+            return readValue(static_cast<Node*>(curr), value);
+        }
+
+        bool contains(const key_type& key) const {
+            mapped_type value;
+            return find(key, value);
+        }
+        //Wstawienie albo nadpisanie wartości; true, gdy klucz był nowy:
+        bool upsert(const key_type& key, const mapped_type& value) {
+            ActiveGuard active(*this);
+            const int height = randomHeight();
+            Tower* preds[MaxLevel];
+            Tower* succs[MaxLevel];
+            while (true) {
+                int found = locate(key, preds, succs);
+                if (found != NotFound) {
+                    Node* existing = static_cast<Node*>(succs[found]);
+                    if (!existing->mMarked.load(std::memory_order_acquire)) {
+                        while (!existing->mFullyLinked.load(std::memory_order_acquire))
+                            std::this_thread::yield();
+                        std::lock_guard<SpinLock> guard(existing->mLock);
+                        if (!existing->mMarked.load(std::memory_order_relaxed)) {
+                            existing->mPair.second = value;
+                            return false;
+                        }
+                    }
+                    continue;//właśnie usuwany - ponowienie
+                }
+
+                int locked;
+                if (!lockPredecessors(preds, succs, height, nullptr, locked)) {
+                    unlockPredecessors(preds, locked);
+                    continue;
+                }
+                Node* node;
+                try {
+                    node = createNode(key, value, height);
+                } catch (...) {
+                    unlockPredecessors(preds, locked);
+                    throw;
+                }
+                raiseLevel(height);
+                for (int level = 0; level < height; ++level)
+                    node->next(level).store(succs[level], std::memory_order_relaxed);
+                for (int level = 0; level < height; ++level)
+                    preds[level]->next(level).store(node, std::memory_order_release);
+                node->mFullyLinked.store(true, std::memory_order_release);
+                unlockPredecessors(preds, locked);
+                mCount.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        //Usunięcie: najpierw oznaczenie węzła (moment usunięcia), potem odpięcie go od poprzedników.
+        //false, gdy klucza nie ma:
+        bool remove(const key_type& key) {
+            ActiveGuard active(*this);
+            Tower* preds[MaxLevel];
+            Tower* succs[MaxLevel];
+            Node* victim = nullptr;
+            while (true) {
+                int found = locate(key, preds, succs);
+                if (victim == nullptr) {
+                    if (found == NotFound)
+                        return false;
+                    Node* candidate = static_cast<Node*>(succs[found]);
+                    //Węzeł znaleziony poniżej swojego szczytu jest jeszcze dołączany albo już odpinany:
+                    if (!candidate->mFullyLinked.load(std::memory_order_acquire) || candidate->mHeight - 1 != found
+                        || candidate->mMarked.load(std::memory_order_acquire))
+                        return false;
+                    candidate->mLock.lock();
+                    if (candidate->mMarked.load(std::memory_order_relaxed)) {
+                        candidate->mLock.unlock();
+                        return false;
+                    }
+                    candidate->mMarked.store(true, std::memory_order_release);
+                    victim = candidate;
+                }
+
+                int locked;
+                if (!lockPredecessors(preds, succs, victim->mHeight, victim, locked)) {
+                    unlockPredecessors(preds, locked);
+                    continue;
+                }
+                for (int level = victim->mHeight - 1; level >= 0; --level)
+                    preds[level]->next(level).store(victim->next(level).load(std::memory_order_relaxed),
+                                                     std::memory_order_release);
+                victim->mLock.unlock();
+                unlockPredecessors(preds, locked);
+                mCount.fetch_sub(1, std::memory_order_relaxed);
+                retire(victim);
+                return true;
+            }
+        }
+        //Wywołanie pFunction(const value_type&) dla kopii elementów o kluczach z [lo, hi), w kolejności kluczy.
+        //Przegląd nie jest migawką: widzi elementy obecne przez cały czas przeglądu, a zmiany
+        //wykonywane w jego trakcie - albo nie:
+        template<typename Function>
+        void forEachInRange(const key_type& lo, const key_type& hi, Function pFunction) const {
+            ActiveGuard active(*this);
+            Tower* pred = mHead;
+            Tower* curr = nullptr;
+            for (int level = mLevel.load(std::memory_order_acquire) - 1; level >= 0; --level) {
+                curr = pred->next(level).load(std::memory_order_acquire);
+                while (curr != nullptr && mCompare(keyOf(curr), lo)) {
+                    pred = curr;
+                    curr = pred->next(level).load(std::memory_order_acquire);
+                }
+            }
+            for (; curr != nullptr && mCompare(keyOf(curr), hi); curr = curr->next(0).load(std::memory_order_acquire)) {
+                mapped_type value;
+                if (isLive(curr) && readValue(static_cast<Node*>(curr), value)) {
+                    const value_type item(keyOf(curr), value);
+                    pFunction(item);
+                }
+            }
+        }
+
+    private:
+        static const int MaxLevel = 24;//2^24 elementów przy oczekiwanej liczbie poziomów
+        static const int NotFound = -1;
+
+        //Krótka blokada aktywna (sekcje krytyczne to kilka zapisów wskaźników albo kopia wartości):
+        class SpinLock {
+        public:
+            SpinLock() : mLocked(false) {}
+
+            void lock() {
+                while (mLocked.exchange(true, std::memory_order_acquire))
+                    while (mLocked.load(std::memory_order_relaxed))
+                        std::this_thread::yield();
+            }
+
+            void unlock() {
+                mLocked.store(false, std::memory_order_release);
+            }
+
+        private:
+            std::atomic<bool> mLocked;
+        };
+        //Wieża wskaźników (głowa listy albo część węzła). Tablica wskaźników leży w tej samej alokacji tuż
+        //przed obiektem (poziom 0 najbliżej), więc głowa i węzły mają ją pod tym samym adresem względnym,
+        //a krok wyszukiwania nie czyta dodatkowego wskaźnika na tablicę:
+        struct Tower {
+            SpinLock mLock;
+            std::atomic<bool> mMarked;//logicznie usunięty
+            std::atomic<bool> mFullyLinked;//dołączony na wszystkich poziomach
+            int mHeight;
+
+            explicit Tower(int pHeight) : mMarked(false), mFullyLinked(false), mHeight(pHeight) {
+                for (int level = 0; level < pHeight; ++level)
+                    new (&next(level)) std::atomic<Tower*>(nullptr);
+            }
+
+            std::atomic<Tower*>& next(int pLevel) {
+                return reinterpret_cast<std::atomic<Tower*>*>(this)[-1 - pLevel];
+            }
+        };
+
+        //Liczy operację jako trwającą (w liczniku jej epoki) przez cały czas, gdy może trzymać wskaźniki
+        //na węzły. Po zwiększeniu licznika epoka jest czytana ponownie: jeśli w międzyczasie się zmieniła,
+        //licznik mógł już zostać sprawdzony przez retire(), więc wejście jest ponawiane:
+        class ActiveGuard {
+        public:
+            explicit ActiveGuard(const ConcurrentSkipListMap& pMap) : mActive(nullptr) {
+                while (true) {
+                    unsigned parity = pMap.mEpoch.load() & 1;
+                    mActive = &pMap.mActive[parity];
+                    mActive->fetch_add(1);
+                    if ((pMap.mEpoch.load() & 1) == parity)
+                        return;
+                    mActive->fetch_sub(1, std::memory_order_release);
+                }
+            }
+
+            ~ActiveGuard() {
+                mActive->fetch_sub(1, std::memory_order_release);
+            }
+
+            ActiveGuard(const ActiveGuard&) = delete;
+            ActiveGuard& operator=(const ActiveGuard&) = delete;
+
+        private:
+            std::atomic<size_type>* mActive;
+        };
+
+        struct Node : Tower {
+            value_type mPair;
+
+            Node(int pHeight, const key_type& pKey, const mapped_type& pValue) : Tower(pHeight), mPair(pKey, pValue) {}
+        };
+
+        Tower* mHead;
+        std::atomic<int> mLevel;//najwyższa wysokość węzła (wyszukiwanie zaczyna od niej, a nie od MaxLevel)
+        std::atomic<size_type> mCount;
+        std::atomic<unsigned> mEpoch;//zmieniana tylko pod mRetiredMutex
+        mutable std::atomic<size_type> mActive[2];//trwające operacje według parzystości epoki ich początku
+        Compare mCompare;
+        std::mutex mRetiredMutex;
+        std::vector<Node*> mRetired[2];//odpięte węzły według parzystości epoki usunięcia
+
+        static const key_type& keyOf(const Tower* pTower) {
+            return static_cast<const Node*>(pTower)->mPair.first;
+        }
+
+        //Odłożenie odpiętego węzła i próba przejścia z epoki e do e + 1. Licznik parzystości e + 1 liczy
+        //operacje rozpoczęte w epoce e - 1; gdy jest zerowy, nikt nie trzyma wskaźników na węzły usunięte
+        //w epoce e - 1 (operacje z epok e i późniejszych zaczęły się po ich odpięciu) - są zwalniane:
+        void retire(Node* pNode) {
+            std::lock_guard<std::mutex> guard(mRetiredMutex);
+            unsigned epoch = mEpoch.load(std::memory_order_relaxed);
+            mRetired[epoch & 1].push_back(pNode);
+            std::vector<Node*>& expired = mRetired[(epoch + 1) & 1];
+            if (mActive[(epoch + 1) & 1].load() != 0)
+                return;
+            for (Node* node : expired)
+                destroyNode(node);
+            expired.clear();
+            mEpoch.store(epoch + 1);
+        }
+
+        static bool isLive(const Tower* pTower) {
+            return pTower->mFullyLinked.load(std::memory_order_acquire) && !pTower->mMarked.load(std::memory_order_acquire);
+        }
+
+        static bool readValue(Node* pNode, mapped_type& pValue) {
+            std::lock_guard<SpinLock> guard(pNode->mLock);
+            if (pNode->mMarked.load(std::memory_order_relaxed))
+                return false;
+            pValue = pNode->mPair.second;
+            return true;
+        }
+        //Poprzednicy i następnicy key na każdym poziomie; zwraca najwyższy poziom, na którym key jest
+        //następnikiem (NotFound, gdy nigdzie):
+        int locate(const key_type& pKey, Tower** pPreds, Tower** pSuccs) const {
+            int found = NotFound;
+            int top = mLevel.load(std::memory_order_acquire);
+            for (int level = top; level < MaxLevel; ++level) {//nowsze wyższe węzły wykryje sprawdzenie przy blokowaniu
+                pPreds[level] = mHead;
+                pSuccs[level] = nullptr;
+            }
+            Tower* pred = mHead;
+            for (int level = top - 1; level >= 0; --level) {
+                Tower* curr = pred->next(level).load(std::memory_order_acquire);
+                while (curr != nullptr && mCompare(keyOf(curr), pKey)) {
+                    pred = curr;
+                    curr = pred->next(level).load(std::memory_order_acquire);
+                }
+                if (found == NotFound && curr != nullptr && !mCompare(pKey, keyOf(curr)))
+                    found = level;
+                pPreds[level] = pred;
+                pSuccs[level] = curr;
+            }
+            return found;
+        }
+        //Blokuje poprzedników od poziomu 0 w górę (ten sam węzeł raz) i sprawdza, że żaden nie jest usunięty
+        //i nadal wskazuje oczekiwanego następnika (pVictim przy usuwaniu, inaczej pSuccs). Kolejność blokad
+        //(malejące klucze) jest ta sama we wszystkich operacjach, więc nie ma zakleszczeń.
+        //pLocked - liczba poziomów, których poprzednicy są zablokowani (także po nieudanym sprawdzeniu):
+        static bool lockPredecessors(Tower** pPreds, Tower** pSuccs, int pHeight, Tower* pVictim, int& pLocked) {
+            for (pLocked = 0; pLocked < pHeight;) {
+                int level = pLocked;
+                Tower* pred = pPreds[level];
+                if (level == 0 || pred != pPreds[level - 1])
+                    pred->mLock.lock();
+                ++pLocked;
+                Tower* succ = pVictim != nullptr ? pVictim : pSuccs[level];
+                if (pred->mMarked.load(std::memory_order_acquire)
+                    || pred->next(level).load(std::memory_order_acquire) != succ
+                    || (pVictim == nullptr && succ != nullptr && succ->mMarked.load(std::memory_order_acquire)))
+                    return false;
+            }
+            return true;
+        }
+
+        static void unlockPredecessors(Tower** pPreds, int pLocked) {
+            for (int level = 0; level < pLocked; ++level)
+                if (level == 0 || pPreds[level] != pPreds[level - 1])
+                    pPreds[level]->mLock.unlock();
+        }
+
+        //Miejsce na tablicę wskaźników przed obiektem, zaokrąglone do wyrównania obiektu:
+        static std::size_t prefixSize(int pHeight, std::size_t pAlignment) {
+            std::size_t size = pHeight * sizeof(std::atomic<Tower*>);
+            return (size + pAlignment - 1) / pAlignment * pAlignment;
+        }
+
+        static Tower* createTower(int pHeight) {
+            std::size_t prefix = prefixSize(pHeight, alignof(Tower));
+            char* memory = static_cast<char*>(::operator new(prefix + sizeof(Tower)));
+            return new (memory + prefix) Tower(pHeight);
+        }
+
+        static void destroyTower(Tower* pTower) {
+            std::size_t prefix = prefixSize(pTower->mHeight, alignof(Tower));
+            pTower->~Tower();
+            ::operator delete(reinterpret_cast<char*>(pTower) - prefix);
+        }
+
+        static Node* createNode(const key_type& pKey, const mapped_type& pValue, int pHeight) {
+            std::size_t prefix = prefixSize(pHeight, alignof(Node));
+            char* memory = static_cast<char*>(::operator new(prefix + sizeof(Node)));
+            try {
+                return new (memory + prefix) Node(pHeight, pKey, pValue);
+            } catch (...) {
+                ::operator delete(memory);
+                throw;
+            }
+        }
+
+        static void destroyNode(Node* pNode) {
+            std::size_t prefix = prefixSize(pNode->mHeight, alignof(Node));
+            pNode->~Node();
+            ::operator delete(reinterpret_cast<char*>(pNode) - prefix);
+        }
+        //Przed dołączeniem węzła, żeby wyszukiwania rozpoczęte po wstawieniu zaczynały dość wysoko:
+        void raiseLevel(int pHeight) {
+            int level = mLevel.load(std::memory_order_relaxed);
+            while (level < pHeight && !mLevel.compare_exchange_weak(level, pHeight, std::memory_order_release,
+                                                                    std::memory_order_relaxed)) {}
+        }
+        //Wysokość z rozkładu geometrycznego (p = 1/2); generator osobny dla każdego wątku:
+        static int randomHeight() {
+            static std::atomic<std::uint64_t> seeds(0);
+            static thread_local std::uint64_t state = 0x9e3779b97f4a7c15ull * (seeds.fetch_add(1) + 1);
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            std::uint64_t bits = state;
+            int height = 1;
+            while (height < MaxLevel && (bits & 1) != 0) {
+                ++height;
+                bits >>= 1;
+            }
+            return height;
+        }
+    };
+
+    template<typename KeyType, typename ValueType, typename Compare>
+    const int ConcurrentSkipListMap<KeyType, ValueType, Compare>::MaxLevel;
+
+    template<typename KeyType, typename ValueType, typename Compare>
+    const int ConcurrentSkipListMap<KeyType, ValueType, Compare>::NotFound;
+
+}
+
+#endif /* AISDI_MAPS_CONCURRENTSKIPLISTMAP_H */
@@ -0,0 +1,358 @@
+#ifndef AISDI_MAPS_DISKHASHMAP_H
+#define AISDI_MAPS_DISKHASHMAP_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace aisdi
+{
+//Słownik na dysku (haszowanie rozszerzalne): elementy w stronach o stałym rozmiarze w pliku,
+//w pamięci tylko katalog (indeksy stron) i ograniczona pamięć podręczna stron (LRU).
+//Klucze i wartości są zapisywane bajtowo, więc muszą być trywialnie kopiowalne.
+//Plik jest roboczy - tworzony od nowa przy konstrukcji mapy.
+//Gdy stronę przepełniają klucze o skrótach zgodnych na MaxDepth najmłodszych bitach, wstawienie
+//rzuca std::length_error (podział nie mógłby ich rozdzielić).
+template <typename KeyType, typename ValueType, typename Hash = std::hash<KeyType>>
+class DiskHashMap
+{
+public:
+    using key_type = KeyType;
+    using mapped_type = ValueType;
+    using size_type = std::size_t;
+
+    static_assert(std::is_trivially_copyable<KeyType>::value, "DiskHashMap key must be trivially copyable.");
+    static_assert(std::is_trivially_copyable<ValueType>::value, "DiskHashMap value must be trivially copyable.");
+
+    static const size_type PageSize = 4096;
+    static const size_type MaxDepth = 32;//katalog 2^32 wpisów to i tak granica pamięci
+
+    DiskHashMap(const std::string& pPath, size_type pCachePages = 64)
+        : mCount(0), mGlobalDepth(0), mPageCount(0), mCacheCapacity(pCachePages < 2 ? 2 : pCachePages),
+          mClock(0), mReads(0), mWrites(0)
+    {
+        mFile.open(pPath, std::ios::in | std::ios::out | std::ios::trunc | std::ios::binary);
+        if (!mFile)
+            throw std::runtime_error("Cannot open file: " + pPath);
+        mFrames.reserve(mCacheCapacity);//referencje do ramek nie mogą się unieważniać
+        mDirectory.push_back(newPage(0));
+    }
+
+    DiskHashMap(const DiskHashMap&) = delete;
+    DiskHashMap& operator=(const DiskHashMap&) = delete;
+
+    //Destruktor nie może rzucać - błąd zapisu jest tu pomijany; kto chce go obsłużyć, woła wcześniej flush():
+    ~DiskHashMap()
+    {
+        try
+        {
+            flush();
+        }
+        catch (...)
+        {
+        }
+    }
+
+    bool isEmpty() const
+    {
+        return mCount == 0;
+    }
+
+    size_type getSize() const
+    {
+        return mCount;
+    }
+    //Wyszukanie - wartość jest kopiowana z bufora strony (strona może zostać wyrzucona z pamięci):
+    bool find(const key_type& key, mapped_type& value)
+    {
+        Frame& frame = load(mDirectory[directoryIndex(key)]);
+        size_type slot = findSlot(frame, key);
+        if (slot == NoSlot)
+            return false;
+        value = readEntry(frame, slot).mValue;
+        return true;
+    }
+
+    mapped_type valueOf(const key_type& key)
+    {
+        mapped_type value;
+        if (!find(key, value))
+            throw std::out_of_range("Key not found.");
+        return value;
+    }
+    //Wstawienie lub nadpisanie wartości:
+    void insert(const key_type& key, const mapped_type& value)
+    {
+        while (true)
+        {
+            Frame& frame = load(mDirectory[directoryIndex(key)]);
+            PageHeader header = readHeader(frame);
+            size_type slot = findSlot(frame, key);
+            if (slot == NoSlot && header.mCount < EntriesPerPage)
+            {
+                slot = header.mCount++;
+                writeHeader(frame, header);
+                ++mCount;
+            }
+            if (slot != NoSlot)
+            {
+                writeEntry(frame, slot, Entry{ key, value });
+                return;
+            }
+            split(key);//strona pełna - podział i ponowna próba
+        }
+    }
+
+    void remove(const key_type& key)
+    {
+        Frame& frame = load(mDirectory[directoryIndex(key)]);
+        size_type slot = findSlot(frame, key);
+        if (slot == NoSlot)
+            throw std::out_of_range("Key not found.");
+        //Ostatni element strony zajmuje miejsce usuwanego:
+        PageHeader header = readHeader(frame);
+        --header.mCount;
+        if (slot != header.mCount)
+            writeEntry(frame, slot, readEntry(frame, header.mCount));
+        writeHeader(frame, header);
+        --mCount;
+    }
+    //Zapis wszystkich zmienionych stron na dysk (rzuca std::runtime_error przy błędzie zapisu):
+    void flush()
+    {
+        for (auto&& frame : mFrames)
+            if (frame.mDirty)
+                writePage(frame);
+        mFile.flush();
+    }
+    //Liczniki operacji wejścia/wyjścia (odczyty i zapisy stron):
+    size_type getReads() const
+    {
+        return mReads;
+    }
+
+    size_type getWrites() const
+    {
+        return mWrites;
+    }
+
+    size_type getPageCount() const
+    {
+        return mPageCount;
+    }
+
+private:
+    struct Entry
+    {
+        key_type mKey;
+        mapped_type mValue;
+    };
+
+    struct PageHeader
+    {
+        std::uint32_t mLocalDepth;
+        std::uint32_t mCount;
+    };
+    //Strona w pamięci podręcznej:
+    struct Frame
+    {
+        std::uint64_t mPage;
+        bool mDirty;
+        size_type mLastUse;
+        std::vector<char> mData;
+    };
+
+    static const size_type EntriesPerPage = (PageSize - sizeof(PageHeader)) / sizeof(Entry);
+    static const size_type NoSlot = static_cast<size_type>(-1);
+    static_assert(EntriesPerPage >= 2, "DiskHashMap entry does not fit twice in a page.");
+
+    size_type mCount;//liczba elementów
+    size_type mGlobalDepth;//liczba bitów skrótu indeksujących katalog
+    std::vector<std::uint64_t> mDirectory;//numery stron dla kolejnych prefiksów skrótu
+    std::uint64_t mPageCount;
+    size_type mCacheCapacity;//maksymalna liczba stron w pamięci
+    std::vector<Frame> mFrames;
+    std::unordered_map<std::uint64_t, size_type> mFrameOf;//strona -> indeks ramki
+    size_type mClock;//licznik użyć dla LRU
+    size_type mReads;
+    size_type mWrites;
+    std::fstream mFile;
+    //Skrót z wymieszaniem bitów (std::hash dla liczb całkowitych to identyczność):
+    static std::uint64_t hash(const key_type& pKey)
+    {
+        std::uint64_t h = Hash{}(pKey);
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    size_type directoryIndex(const key_type& pKey) const
+    {
+        return static_cast<size_type>(hash(pKey) & ((std::uint64_t(1) << mGlobalDepth) - 1));
+    }
+    //Podział pełnej strony, do której trafia dany klucz:
+    void split(const key_type& pKey)
+    {
+        std::uint64_t oldPage = mDirectory[directoryIndex(pKey)];
+        Frame& old = load(oldPage);
+        std::uint32_t depth = readHeader(old).mLocalDepth;
+        //Kolejne podziały rozdzielą stronę dopiero na najmłodszym bicie, na którym różnią się skróty:
+        std::uint64_t first = hash(pKey);
+        std::uint64_t differ = 0;
+        for (std::uint32_t i = 0; i < readHeader(old).mCount; ++i)
+            differ |= hash(readEntry(old, i).mKey) ^ first;
+        if ((differ & ((std::uint64_t(1) << MaxDepth) - 1)) == 0)
+            throw std::length_error("Too many keys with colliding hashes.");
+        if (depth == mGlobalDepth)//podwojenie katalogu
+        {
+            size_type size = mDirectory.size();
+            for (size_type i = 0; i < size; ++i)
+                mDirectory.push_back(mDirectory[i]);
+            ++mGlobalDepth;
+        }
+
+        std::uint64_t newPage = this->newPage(depth + 1);
+        for (size_type i = 0; i < mDirectory.size(); ++i)
+            if (mDirectory[i] == oldPage && ((i >> depth) & 1) != 0)
+                mDirectory[i] = newPage;
+        //Rozdzielenie elementów według bitu depth skrótu:
+        Frame& from = load(oldPage);
+        Frame& to = load(newPage);
+        PageHeader fromHeader = readHeader(from);
+        PageHeader toHeader = readHeader(to);
+        std::uint32_t kept = 0;
+        for (std::uint32_t i = 0; i < fromHeader.mCount; ++i)
+        {
+            Entry entry = readEntry(from, i);
+            if (((hash(entry.mKey) >> depth) & 1) != 0)
+                writeEntry(to, toHeader.mCount++, entry);
+            else
+                writeEntry(from, kept++, entry);
+        }
+        fromHeader.mCount = kept;
+        fromHeader.mLocalDepth = depth + 1;
+        writeHeader(from, fromHeader);
+        writeHeader(to, toHeader);
+    }
+
+    size_type findSlot(const Frame& pFrame, const key_type& pKey) const
+    {
+        PageHeader header = readHeader(pFrame);
+        for (size_type i = 0; i < header.mCount; ++i)
+            if (readEntry(pFrame, i).mKey == pKey)
+                return i;
+        return NoSlot;
+    }
+    //Dostęp do zawartości strony przez memcpy (bufor nie ma wyrównania typów K/V):
+    static PageHeader readHeader(const Frame& pFrame)
+    {
+        PageHeader header;
+        std::memcpy(&header, pFrame.mData.data(), sizeof(header));
+        return header;
+    }
+
+    static void writeHeader(Frame& pFrame, const PageHeader& pHeader)
+    {
+        std::memcpy(pFrame.mData.data(), &pHeader, sizeof(pHeader));
+        pFrame.mDirty = true;
+    }
+
+    static Entry readEntry(const Frame& pFrame, size_type pSlot)
+    {
+        Entry entry;
+        std::memcpy(&entry, pFrame.mData.data() + sizeof(PageHeader) + pSlot * sizeof(Entry), sizeof(Entry));
+        return entry;
+    }
+
+    static void writeEntry(Frame& pFrame, size_type pSlot, const Entry& pEntry)
+    {
+        std::memcpy(pFrame.mData.data() + sizeof(PageHeader) + pSlot * sizeof(Entry), &pEntry, sizeof(Entry));
+        pFrame.mDirty = true;
+    }
+    //Nowa, pusta strona na końcu pliku (od razu w pamięci podręcznej):
+    std::uint64_t newPage(std::uint32_t pLocalDepth)
+    {
+        std::uint64_t page = mPageCount++;
+        Frame& frame = acquireFrame(page);
+        std::fill(frame.mData.begin(), frame.mData.end(), 0);
+        writeHeader(frame, PageHeader{ pLocalDepth, 0 });
+        return page;
+    }
+    //Strona w pamięci podręcznej (wczytywana z dysku w razie potrzeby):
+    Frame& load(std::uint64_t pPage)
+    {
+        auto it = mFrameOf.find(pPage);
+        if (it != mFrameOf.end())
+        {
+            Frame& frame = mFrames[it->second];
+            frame.mLastUse = ++mClock;
+            return frame;
+        }
+        Frame& frame = acquireFrame(pPage);
+        mFile.seekg(static_cast<std::streamoff>(pPage * PageSize));
+        mFile.read(frame.mData.data(), PageSize);
+        if (!mFile)
+            throw std::runtime_error("Page read failed.");
+        ++mReads;
+        return frame;
+    }
+    //Ramka dla strony: wolna lub zwolniona przez wyrzucenie najdawniej używanej
+    //(nigdy ostatnio użytej, więc dwie strony pobrane po kolei są jednocześnie w pamięci):
+    Frame& acquireFrame(std::uint64_t pPage)
+    {
+        size_type index = mFrames.size();
+        if (index < mCacheCapacity)
+            mFrames.push_back(Frame{ 0, false, 0, std::vector<char>(PageSize) });
+        else
+        {
+            index = 0;
+            for (size_type i = 1; i < mFrames.size(); ++i)
+                if (mFrames[i].mLastUse < mFrames[index].mLastUse)
+                    index = i;
+            if (mFrames[index].mDirty)
+                writePage(mFrames[index]);
+            mFrameOf.erase(mFrames[index].mPage);
+        }
+        Frame& frame = mFrames[index];
+        frame.mPage = pPage;
+        frame.mDirty = false;
+        frame.mLastUse = ++mClock;
+        mFrameOf[pPage] = index;
+        return frame;
+    }
+
+    void writePage(Frame& pFrame)
+    {
+        mFile.seekp(static_cast<std::streamoff>(pFrame.mPage * PageSize));
+        mFile.write(pFrame.mData.data(), PageSize);
+        if (!mFile)
+            throw std::runtime_error("Page write failed.");
+        pFrame.mDirty = false;
+        ++mWrites;
+    }
+};
+
+template <typename KeyType, typename ValueType, typename Hash>
+const typename DiskHashMap<KeyType, ValueType, Hash>::size_type DiskHashMap<KeyType, ValueType, Hash>::PageSize;
+
+template <typename KeyType, typename ValueType, typename Hash>
+const typename DiskHashMap<KeyType, ValueType, Hash>::size_type DiskHashMap<KeyType, ValueType, Hash>::MaxDepth;
+
+template <typename KeyType, typename ValueType, typename Hash>
+const typename DiskHashMap<KeyType, ValueType, Hash>::size_type DiskHashMap<KeyType, ValueType, Hash>::EntriesPerPage;
+
+template <typename KeyType, typename ValueType, typename Hash>
+const typename DiskHashMap<KeyType, ValueType, Hash>::size_type DiskHashMap<KeyType, ValueType, Hash>::NoSlot;
+
+}
+
+#endif /* AISDI_MAPS_DISKHASHMAP_H */
@@ -0,0 +1,195 @@
+#ifndef AISDI_MAPS_FROZENMAP_H
+#define AISDI_MAPS_FROZENMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace aisdi {
+
+    //Niezmienna mapa tylko do odczytu (zwykle wynik TreeMap::freeze()). Elementy leżą w posortowanej
+    //tablicy (iteracja), a klucze osobno w porządku Eytzingera (BFS niejawnego drzewa: dzieci
+    //pozycji k to 2k i 2k+1). Wyszukiwanie schodzi po tej tablicy bez skoków warunkowych, a szesnastu
+    //potomków cztery poziomy niżej leży obok siebie, więc można je pobrać z wyprzedzeniem.
+    template<typename KeyType, typename ValueType, typename Compare = std::less<KeyType>>
+    class FrozenMap {
+    public:
+        using key_type = KeyType;
+        using key_compare = Compare;
+        using mapped_type = ValueType;
+        using value_type = std::pair<const key_type, mapped_type>;
+        using size_type = std::size_t;
+        using const_reference = const value_type&;
+        using const_iterator = typename std::vector<value_type>::const_iterator;
+        using iterator = const_iterator;
+
+        FrozenMap() : FrozenMap(Compare()) {}
+
+        explicit FrozenMap(const Compare& pCompare) : mCompare(pCompare) {}
+
+        //Budowa z par o ściśle rosnących kluczach w O(n):
+        template<typename ForwardIt>
+        FrozenMap(ForwardIt first, ForwardIt last, const Compare& pCompare = Compare()) : mCompare(pCompare) {
+            for (ForwardIt it = first, previous = first; it != last; previous = it, ++it) {
+                if (!mItems.empty() && !mCompare(previous->first, it->first))
+                    throw std::invalid_argument("Keys are not sorted.");
+                if (mItems.size() == MaxSize)
+                    throw std::length_error("Too many elements.");
+                mItems.push_back(*it);
+            }
+            layOut();
+        }
+
+        FrozenMap(const FrozenMap&) = default;
+        FrozenMap(FrozenMap&&) = default;
+        //Przypisanie przez zamianę tablic - elementy z kluczem const nie dają się przypisywać pojedynczo:
+        FrozenMap& operator=(FrozenMap other) {
+            mItems.swap(other.mItems);
+            mKeys.swap(other.mKeys);
+            mOrder.swap(other.mOrder);
+            std::swap(mCompare, other.mCompare);
+            return *this;
+        }
+
+        bool isEmpty() const {
+            return mItems.empty();
+        }
+
+        size_type getSize() const {
+            return mItems.size();
+        }
+
+        const mapped_type& valueOf(const key_type& key) const {
+            const_iterator it = find(key);
+            if (it == end())
+                throw std::out_of_range("Key not found.");
+            return it->second;
+        }
+
+        const_iterator find(const key_type& key) const {
+            return findItem(key);
+        }
+
+        template<typename K, typename C = Compare, typename = typename C::is_transparent>
+        const_iterator find(const K& key) const {
+            return findItem(key);
+        }
+        //Pierwszy element o kluczu >= key (end, gdy brak):
+        const_iterator lowerBound(const key_type& key) const {
+            return mItems.begin() + lowerBoundIndex(key);
+        }
+
+        template<typename K, typename C = Compare, typename = typename C::is_transparent>
+        const_iterator lowerBound(const K& key) const {
+            return mItems.begin() + lowerBoundIndex(key);
+        }
+
+        const_iterator begin() const {
+            return mItems.begin();
+        }
+
+        const_iterator end() const {
+            return mItems.end();
+        }
+
+        const_iterator cbegin() const {
+            return mItems.cbegin();
+        }
+
+        const_iterator cend() const {
+            return mItems.cend();
+        }
+
+    private:
+        static const size_type MaxSize = 0xffffffffu;
+        //Odległość pobierania z wyprzedzeniem: 2^4 = 16 potomków cztery poziomy niżej:
+        static const size_type PrefetchLevels = 4;
+
+        std::vector<value_type> mItems;//elementy w porządku rosnącym
+        std::vector<key_type> mKeys;//klucze w porządku Eytzingera od pozycji 1 (pozycja 0 to wypełnienie)
+        std::vector<std::uint32_t> mOrder;//pozycja w mItems dla pozycji w mKeys
+        Compare mCompare;
+
+        //Rozmieszczenie kluczy: przejście in-order niejawnego drzewa odwiedza pozycje Eytzingera
+        //w kolejności rosnących kluczy, więc k-ta odwiedzona pozycja dostaje k-ty element:
+        void layOut() {
+            size_type count = mItems.size();
+            if (count == 0)
+                return;
+            mOrder.assign(count + 1, 0);
+            size_type position = 1;
+            while (2 * position <= count)
+                position *= 2;
+            for (size_type index = 0; position != 0; ++index) {
+                mOrder[position] = static_cast<std::uint32_t>(index);
+                if (2 * position + 1 <= count) {
+                    position = 2 * position + 1;
+                    while (2 * position <= count)
+                        position *= 2;
+                } else {
+                    while ((position & 1) != 0)
+                        position >>= 1;
+                    position >>= 1;
+                }
+            }
+            mKeys.reserve(count + 1);
+            mKeys.push_back(mItems[0].first);
+            for (size_type k = 1; k <= count; ++k)
+                mKeys.push_back(mItems[mOrder[k]].first);
+        }
+
+        template<typename K>
+        const_iterator findItem(const K& pKey) const {
+            size_type index = lowerBoundIndex(pKey);
+            if (index == mItems.size() || mCompare(pKey, mItems[index].first))
+                return end();
+            return mItems.begin() + index;
+        }
+        //Zejście bez rozgałęzień: w prawo (2k+1), gdy klucz pozycji jest mniejszy, inaczej w lewo (2k).
+        //Po wyjściu poza tablicę ostatni skręt w lewo wskazuje wynik - usuwamy z k końcowe jedynki
+        //(skręty w prawo) i jeszcze ten jeden bit. Zwraca pozycję w mItems (getSize(), gdy brak):
+        template<typename K>
+        size_type lowerBoundIndex(const K& pKey) const {
+            size_type count = mItems.size();
+            size_type k = 1;
+            while (k <= count) {
+                prefetch(k << PrefetchLevels);
+                k = 2 * k + static_cast<size_type>(mCompare(mKeys[k], pKey));
+            }
+            k >>= trailingOnes(k) + 1;
+            return k == 0 ? count : mOrder[k];
+        }
+        //Adres liczony na liczbach (pozycja może wyjść poza tablicę - prefetch to tylko podpowiedź):
+        void prefetch(size_type pPosition) const {
+#if defined(__GNUC__)
+            __builtin_prefetch(reinterpret_cast<const void*>(
+                reinterpret_cast<std::uintptr_t>(mKeys.data()) + pPosition * sizeof(key_type)));
+#else
+            (void)pPosition;
+#endif
+        }
+
+        static unsigned trailingOnes(size_type pValue) {
+#if defined(__GNUC__)
+            return static_cast<unsigned>(__builtin_ctzll(~static_cast<unsigned long long>(pValue)));
+#else
+            unsigned count = 0;
+            for (; (pValue & 1) != 0; pValue >>= 1)
+                ++count;
+            return count;
+#endif
+        }
+    };
+
+    template<typename KeyType, typename ValueType, typename Compare>
+    const typename FrozenMap<KeyType, ValueType, Compare>::size_type FrozenMap<KeyType, ValueType, Compare>::MaxSize;
+
+    template<typename KeyType, typename ValueType, typename Compare>
+    const typename FrozenMap<KeyType, ValueType, Compare>::size_type FrozenMap<KeyType, ValueType, Compare>::PrefetchLevels;
+
+}
+
+#endif /* AISDI_MAPS_FROZENMAP_H */
@@ -2,16 +2,157 @@
 #define AISDI_MAPS_HASHMAP_H
 
 #include <cstddef>
+#include <cstdint>
 #include <initializer_list>
 #include <stdexcept>
 #include <utility>
 #include <functional>//std::hash dla typów wbudowanych
+#include <atomic>
+#include <new>
+#include <type_traits>
 #include <iostream>
 
 namespace aisdi
 {
+//Polityki wyznaczania indeksu wiaderka ze skrótu (parametr szablonu HashMap).
+//Każda dostaje żądaną liczbę wiaderek i podaje faktyczną (może ją zaokrąglić w górę).
 
-template <typename KeyType, typename ValueType>
+//Reszta z dzielenia przez dowolną liczbę wiaderek (dzielenie 64-bitowe w czasie wykonania):
+class ModuloIndex
+{
+public:
+    explicit ModuloIndex(std::size_t pBuckets) : mBuckets(pBuckets) {}
+
+    std::size_t bucketCount() const
+    {
+        return mBuckets;
+    }
+
+    std::size_t operator()(std::size_t pHash) const
+    {
+        return pHash % mBuckets;
+    }
+
+private:
+    std::size_t mBuckets;
+};
+//Potęga dwójki: mnożenie przez złotą proporcję (mieszanie) i górne bity zamiast dzielenia:
+class PowerOfTwoIndex
+{
+public:
+    explicit PowerOfTwoIndex(std::size_t pBuckets) : mShift(64)
+    {
+        while (mShift > 1 && (std::uint64_t(1) << (64 - mShift)) < pBuckets)
+            --mShift;
+    }
+
+    std::size_t bucketCount() const
+    {
+        return static_cast<std::size_t>(std::uint64_t(1) << (64 - mShift));
+    }
+
+    std::size_t operator()(std::size_t pHash) const
+    {
+        if (mShift == 64)//jedno wiaderko (przesunięcie o 64 bity jest niezdefiniowane)
+            return 0;
+        return static_cast<std::size_t>((pHash * 0x9E3779B97F4A7C15ULL) >> mShift);
+    }
+
+private:
+    unsigned mShift;//64 - log2(liczba wiaderek)
+};
+//Lemire "fastrange": 32-bitowy wymieszany skrót razy liczba wiaderek, górne 32 bity wyniku:
+class FastRangeIndex
+{
+public:
+    explicit FastRangeIndex(std::size_t pBuckets) : mBuckets(pBuckets) {}
+
+    std::size_t bucketCount() const
+    {
+        return static_cast<std::size_t>(mBuckets);
+    }
+
+    std::size_t operator()(std::size_t pHash) const
+    {
+        std::uint64_t mixed = (pHash * 0x9E3779B97F4A7C15ULL) >> 32;
+        return static_cast<std::size_t>((mixed * mBuckets) >> 32);
+    }
+
+private:
+    std::uint64_t mBuckets;
+};
+//Tabela liczb pierwszych dla PrimeIndex (szablon, aby definicja w nagłówku nie łamała ODR):
+template <typename Dummy>
+struct PrimeTable
+{
+    static const std::size_t Values[29];
+};
+
+template <typename Dummy>
+const std::size_t PrimeTable<Dummy>::Values[29] = {
+    5, 11, 23, 53, 97, 193, 389, 769, 1543, 3079, 6151, 12289, 24593, 49157, 98317, 196613, 393241,
+    786433, 1572869, 3145739, 6291469, 12582917, 25165843, 50331653, 100663319, 201326611, 402653189,
+    805306457, 1610612741
+};
+
+//Liczba pierwsza z tabeli; switch po numerze pozwala kompilatorowi zamienić dzielenie
+//przez stałą na mnożenie i przesunięcia:
+class PrimeIndex
+{
+public:
+    explicit PrimeIndex(std::size_t pBuckets) : mPrime(0)
+    {
+        while (mPrime + 1 < PrimeCount && PrimeTable<void>::Values[mPrime] < pBuckets)
+            ++mPrime;
+    }
+
+    std::size_t bucketCount() const
+    {
+        return PrimeTable<void>::Values[mPrime];
+    }
+
+    std::size_t operator()(std::size_t pHash) const
+    {
+        switch (mPrime)
+        {
+        case 0: return pHash % 5ULL;
+        case 1: return pHash % 11ULL;
+        case 2: return pHash % 23ULL;
+        case 3: return pHash % 53ULL;
+        case 4: return pHash % 97ULL;
+        case 5: return pHash % 193ULL;
+        case 6: return pHash % 389ULL;
+        case 7: return pHash % 769ULL;
+        case 8: return pHash % 1543ULL;
+        case 9: return pHash % 3079ULL;
+        case 10: return pHash % 6151ULL;
+        case 11: return pHash % 12289ULL;
+        case 12: return pHash % 24593ULL;
+        case 13: return pHash % 49157ULL;
+        case 14: return pHash % 98317ULL;
+        case 15: return pHash % 196613ULL;
+        case 16: return pHash % 393241ULL;
+        case 17: return pHash % 786433ULL;
+        case 18: return pHash % 1572869ULL;
+        case 19: return pHash % 3145739ULL;
+        case 20: return pHash % 6291469ULL;
+        case 21: return pHash % 12582917ULL;
+        case 22: return pHash % 25165843ULL;
+        case 23: return pHash % 50331653ULL;
+        case 24: return pHash % 100663319ULL;
+        case 25: return pHash % 201326611ULL;
+        case 26: return pHash % 402653189ULL;
+        case 27: return pHash % 805306457ULL;
+        default: return pHash % 1610612741ULL;
+        }
+    }
+
+private:
+    static const std::size_t PrimeCount = 29;
+    std::size_t mPrime;//numer liczby pierwszej w tabeli
+};
+
+template <typename KeyType, typename ValueType, typename IndexPolicy = ModuloIndex>
 class HashMap
 {
 public:
@@ -24,15 +165,53 @@ public:
 
     class ConstIterator;
     class Iterator;
-    class BucketNode;
     using iterator = Iterator;
     using const_iterator = ConstIterator;
-    //Konstruktor przyjmuje liczbę "wiaderek", tworzy tablicę wskaźników na węzły (listę węzłów)
-    HashMap(size_type Buckets = 50): mBucketCount(Buckets), mCount(0)
+    //Pojedynczy "węzeł" hashmapy (zdefiniowany w klasie - rozmiar potrzebny dla pamięci małej mapy):
+    struct BucketNode
+    {   //Para klucz/wartość:
+        value_type mPair;
+        //Wskaźnik na następny węzeł w wiaderku:
+        BucketNode* mNextNode;
+        //Wskaźnik na poprzedni węzeł w wiaderku (nullptr dla pierwszego):
+        BucketNode* mPrevNode;
+        //Liczba map współdzielących łańcuch (znacząca tylko w pierwszym węźle wiaderka):
+        std::atomic<size_type> mRefs;
+        //Konstruktory:
+        BucketNode(const key_type& pKey) : mPair(std::make_pair(pKey, ValueType {})), mNextNode(nullptr), mPrevNode(nullptr), mRefs(1) {}
+        BucketNode(const key_type& pKey, mapped_type pData) : mPair(std::make_pair(pKey, pData)), mNextNode(nullptr), mPrevNode(nullptr), mRefs(1) {}
+        BucketNode(value_type pPair) : mPair(pPair), mNextNode(nullptr), mPrevNode(nullptr), mRefs(1) {}
+    };
+    //Liczba elementów przechowywanych bezpośrednio w obiekcie mapy, zanim powstanie tablica wiaderek:
+    static const size_type SmallCapacity = 8;
+    //Liczba przeplatanych wyszukiwań w findMany:
+    static const size_type LookupGroupSize = 16;
+    //Zużycie pamięci w bajtach według kategorii (suma = total()). Liczone są rozmiary obiektów,
+    //bez pamięci dynamicznej samych kluczy/wartości (np. bufora std::string); współdzielone
+    //z migawkami wiaderka liczą się w każdej mapie, która je widzi:
+    struct MemoryUsage
+    {
+        size_type mObject;//obiekt mapy (bez slotów zajętych przez elementy małej mapy)
+        size_type mBuckets;//tablica wiaderek
+        size_type mNodes;//narzut węzłów: wskaźniki, licznik współdzielenia, wyrównanie
+        size_type mKeys;
+        size_type mValues;
+
+        size_type total() const
+        {
+            return mObject + mBuckets + mNodes + mKeys + mValues;
+        }
+    };
+    //Wywoływana, gdy wstawienie przekroczyłoby budżet; dostaje mapę i przewidywane zużycie,
+    //zwraca true, jeśli wstawienie ma się mimo to odbyć:
+    using BudgetCallback = std::function<bool(const HashMap&, size_type)>;
+
+    //Konstruktor przyjmuje liczbę "wiaderek"; tablica wiaderek powstaje dopiero,
+    //gdy elementów jest więcej niż SmallCapacity (wcześniej mapa ma jedno wewnętrzne wiaderko)
+    HashMap(size_type Buckets = 50): mBucketCount(1), mCount(0), mTableSize(Buckets), mIndex(Buckets), mMemoryBudget(0),
+                                     mSmallHead(nullptr), mSmallUsed(0), mSmallHashes()
     {
-        mBuckets = new BucketNode*[mBucketCount];
-        for(size_type i = 0; i<mBucketCount; ++i)
-            mBuckets[i] = nullptr;
+        mBuckets = &mSmallHead;
         mHasher = [](const key_type& pKey) {
             return std::hash<key_type>{}(pKey);
         };
@@ -45,42 +224,62 @@ public:
 
     }
 
-    HashMap(const HashMap& other):HashMap()
+    //Kopia współdzieli łańcuchy wiaderek z oryginałem (copy-on-write), koszt O(liczba wiaderek);
+    //mała mapa jest po prostu kopiowana (najwyżej SmallCapacity elementów). Copy-on-write działa
+    //tylko przy dostępie przez interfejs mapy, więc referencje i iteratory pobrane z oryginału przed
+    //kopiowaniem nie nadają się już do zapisu:
+    HashMap(const HashMap& other):HashMap(other.mTableSize)
     {
         mHasher = other.mHasher;
-        for(auto it = other.cbegin(); it != other.cend(); ++it)
-            insert((*it).first, (*it).second);
+        copyFrom(other);
     }
 
-    HashMap(HashMap&& other):HashMap()
+    ~HashMap()
     {
-        std::swap(mCount, other.mCount);
-        std::swap(mBuckets, other.mBuckets);
-        std::swap(mBucketCount, other.mBucketCount);
-        std::swap(mHasher, other.mHasher);
+        clear();
+        if (!isSmall())
+            delete[] mBuckets;
+    }
+
+    HashMap(HashMap&& other):HashMap(other.mTableSize)
+    {
+        mHasher = other.mHasher;
+        takeFrom(other);
     }
 
     HashMap& operator=(const HashMap& other)
     {
-        if(*this == other)
+        if(this == &other)
             return *this;
-        clear();
-        for(auto&& item : other)
-        {
-            insert(item.first, item.second);
-        }
+        reset();
+        mTableSize = other.mTableSize;
+        mIndex = other.mIndex;
+        mHasher = other.mHasher;
+        copyFrom(other);
         return *this;
     }
 
     HashMap& operator=(HashMap&& other)
     {
-        std::swap(mCount, other.mCount);
-        std::swap(mBuckets, other.mBuckets);
-        std::swap(mBucketCount, other.mBucketCount);
-        std::swap(mHasher, other.mHasher);
-        other.mCount = 0;
+        if(this == &other)
+            return *this;
+        reset();
+        mTableSize = other.mTableSize;
+        mIndex = other.mIndex;
+        mHasher = other.mHasher;
+        takeFrom(other);
         return *this;
     }
+    //Migawka: niezmienny widok bieżącej zawartości, współdzielący niezmienione wiaderka z mapą.
+    //Zapis do mapy kopiuje tylko modyfikowane wiaderko, więc migawkę można czytać z innego wątku
+    //bez blokowania piszącego (sama migawka musi zostać wykonana przez wątek piszący).
+    //Uwaga: podobnie jak kopia, migawka unieważnia do zapisu referencje i iteratory pobrane z mapy
+    //wcześniej - wskazują na węzły współdzielone z migawką, więc zapis przez nie zmieniłby ją
+    //(i ścigał się z czytającym). Po migawce elementy trzeba pobrać z mapy na nowo.
+    const HashMap snapshot() const
+    {
+        return HashMap(*this);
+    }
 
     bool isEmpty() const
     {
@@ -90,9 +289,8 @@ public:
     mapped_type& operator[](const key_type& key)
     {
         size_type tempBucket = bucketHash(key);
-        BucketNode* tempNode = mBuckets[tempBucket];//Wyszukanie początkowego node'a w odpowiednim wiaderku
-        while(tempNode != nullptr && tempNode->mPair.first != key)
-            tempNode = tempNode->mNextNode;
+        makeUnique(tempBucket);//zwracamy referencję do zapisu
+        BucketNode* tempNode = findNode(key, tempBucket);
         if (tempNode == nullptr)
             return (*insert(key)).second;
         else
@@ -110,74 +308,100 @@ public:
     //Rzutowanie w celu zmniejszenia objętości kodu:
     mapped_type& valueOf(const key_type& key)
     {
-        return const_cast<mapped_type&>(static_cast<const HashMap<KeyType, ValueType>*>(this)->valueOf(key));
+        makeUnique(bucketHash(key));
+        return const_cast<mapped_type&>(static_cast<const HashMap*>(this)->valueOf(key));
     }
 
     const_iterator find(const key_type& key) const
     {
         size_type bucket = bucketHash(key);
-        BucketNode* temp = mBuckets[bucket];
-        while (temp != nullptr && temp->mPair.first != key)
-            temp = temp->mNextNode;
+        BucketNode* temp = findNode(key, bucket);
         if (temp == nullptr)
             return end();
         return ConstIterator(*this, bucket, temp);
     }
+    //Wyszukiwanie wsadowe: do LookupGroupSize wyszukiwań naraz, każde jako mały automat stanów
+    //zatrzymujący się po zleceniu prefetch następnego węzła, tak by chybienia w cache nakładały się.
+    //Dla każdego klucza z [first, last) zapisuje do out iterator (end() gdy brak), w tej samej kolejności.
+    template <typename ForwardIt, typename OutputIt>
+    OutputIt findMany(ForwardIt first, ForwardIt last, OutputIt out) const
+    {
+        Lookup group[LookupGroupSize];
+        while (first != last)
+        {
+            size_type count = 0;
+            size_type pending = 0;
+            for (; first != last && count < LookupGroupSize; ++first, ++count)
+            {
+                startLookup(group[count], *first);//klucz czytany przez wskaźnik - musi żyć w zakresie
+                if (!group[count].mDone)
+                    ++pending;
+            }
+
+            while (pending != 0)
+                for (size_type i = 0; i < count; ++i)
+                    if (!group[i].mDone && stepLookup(group[i]))
+                        --pending;
+
+            for (size_type i = 0; i < count; ++i)
+                *out++ = group[i].mNode == nullptr ? cend() : ConstIterator(*this, group[i].mBucket, group[i].mNode);
+        }
+        return out;
+    }
     //Rzutowanie w celu zmniejszenia objętości kodu:
     iterator find(const key_type& key)
     {
-        return static_cast<const HashMap<KeyType, ValueType>*>(this)->find(key);
+        return static_cast<const HashMap*>(this)->find(key);//konwersja na Iterator kopiuje wiaderko
     }
     //Usuwanie elementu:
     void remove(const key_type& key)
     {
         size_type bucket = bucketHash(key);
-        BucketNode* temp = mBuckets[bucket];
-        //Jeżeli nie ma takiego wiaderka:
+        makeUnique(bucket);
+        BucketNode* temp = findNode(key, bucket);
         if (temp == nullptr)
             throw std::out_of_range("Key not found.");
-
-        if (temp->mPair.first == key) // w przypadku gdy jest to element pierwszy w danym wiaderku
-        {
-            mBuckets[bucket] = temp->mNextNode;
-            delete temp;
-            --mCount;
-            return;
-        }
-        //Przeszukiwanie wiaderka:
-        while (temp != nullptr && temp->mNextNode != nullptr && temp->mNextNode->mPair.first != key)
-            temp = temp->mNextNode;
-
-        if (temp == nullptr)
-            throw std::out_of_range("Key not found");
-        else{
-        temp->mNextNode = (temp->mNextNode)->mNextNode;
-        --mCount;
-        delete temp;
-        }
+        unlink(bucket, temp);
     }
 
     void remove(const const_iterator& it)
+    {
+        erase(it);
+    }
+    //Usuwa element wskazywany przez iterator i zwraca iterator na następny (O(1) - węzły znają poprzednika):
+    iterator erase(const const_iterator& it)
     {
         if (it == end())
             throw std::out_of_range("Trying to remove end.");
 
-        BucketNode* temp;
-        temp = mBuckets[it.mBucket];
-
-        if (temp == it.mNode)//jeżeli pierwszy
+        BucketNode* node = makeUnique(it.mBucket, it.mNode);
+        iterator next(*this, it.mBucket, node);
+        ++next;//wyznaczany przed usunięciem węzła
+        unlink(it.mBucket, node);
+        return next;
+    }
+    //Usuwa w jednym przejściu wszystkie elementy spełniające predykat, zwraca liczbę usuniętych:
+    template <typename Predicate>
+    size_type eraseIf(Predicate pred)
+    {
+        size_type removed = 0;
+        for (size_type i = 0; i < mBucketCount; ++i)
         {
-            mBuckets[it.mBucket] = temp->mNextNode;
-            delete temp;
-            --mCount;
-            return;
+            BucketNode* node = mBuckets[i];
+            while (node != nullptr)
+            {
+                BucketNode* next = node->mNextNode;
+                if (pred(const_cast<const_reference>(node->mPair)))
+                {
+                    node = makeUnique(i, node);
+                    next = node->mNextNode;
+                    unlink(i, node);
+                    ++removed;
+                }
+                node = next;
+            }
         }
-
-        while (temp->mNextNode != it.mNode)
-            temp = temp->mNextNode;
-        temp->mNextNode = temp->mNextNode->mNextNode;
-        --mCount;
-        delete temp;
+        return removed;
     }
 
     size_type getSize() const
@@ -185,25 +409,33 @@ public:
         return mCount;
     }
 
+    MemoryUsage memoryUsage() const
+    {
+        return usageFor(mCount, isSmall(), mBucketCount);
+    }
+    //Budżet pamięci (0 - brak): wstawienie, po którym memoryUsage().total() przekroczyłoby budżet,
+    //woła callback, a bez niego (lub gdy zwróci false) rzuca std::length_error:
+    void setMemoryBudget(size_type pBytes, BudgetCallback pOnExceeded = BudgetCallback())
+    {
+        mMemoryBudget = pBytes;
+        mOnBudgetExceeded = pOnExceeded;
+    }
+
+    size_type getMemoryBudget() const
+    {
+        return mMemoryBudget;
+    }
+
     bool operator==(const HashMap& other) const
     {
         if (mCount != other.mCount)
             return false;
-
-        for (size_type i = 0; i < mBucketCount; ++i)
-        {   //Czy mają wiaderka o danym indeksie:
-            if ((mBuckets[i] == nullptr && other.mBuckets[i] != nullptr) ||
-                    (mBuckets[i] != nullptr && other.mBuckets[i] == nullptr))
+        //Mapy mogą mieć różny układ wiaderek (np. mała i duża), więc porównujemy element po elemencie:
+        for (auto it = cbegin(); it != cend(); ++it)
+        {
+            auto found = other.find(it->first);
+            if (found == other.cend() || found->second != it->second)
                 return false;
-
-            //Sprawdzanie w przypadku gdy są elementy:
-            BucketNode* node = mBuckets[i];
-            while (node != nullptr)
-            {
-                if (other.find(node->mPair.first)->second != node->mPair.second)
-                    return false;
-                node = node->mNextNode;
-            }
         }
 
         return true;
@@ -216,7 +448,7 @@ public:
 
     iterator begin()
     {
-        return Iterator(*this, 0, mBuckets[0]);
+        return Iterator(*this, 0, mBuckets[0]);//Iterator sam kopiuje współdzielone wiaderka, do których wchodzi
     }
 
     iterator end()
@@ -245,15 +477,214 @@ public:
     }
 
 private:
+    using SmallSlot = typename std::aligned_storage<sizeof(BucketNode), alignof(BucketNode)>::type;
+    //Stan jednego wyszukiwania w findMany:
+    struct Lookup
+    {
+        const key_type* mKey;
+        size_type mBucket;
+        BucketNode* mNode;//bieżący węzeł, po zakończeniu znaleziony (lub nullptr)
+        bool mLoaded;//czy wczytano już początek wiaderka
+        bool mDone;
+    };
+
     size_type mBucketCount;//liczba wiaderek
     size_type mCount;// liczba wszystkich węzłów
-    BucketNode** mBuckets;
+    BucketNode** mBuckets;//w trybie małej mapy wskazuje na mSmallHead
+    size_type mTableSize;//żądana liczba wiaderek (po przekroczeniu SmallCapacity)
+    IndexPolicy mIndex;//skrót -> indeks wiaderka, zna faktyczną liczbę wiaderek
     //Funkcja hashująca (standardowa):
     std::function<size_type(const key_type&)> mHasher;
+    size_type mMemoryBudget;//0 - bez limitu; nie jest kopiowany razem z zawartością
+    BudgetCallback mOnBudgetExceeded;
+    //Pamięć małej mapy: jedyne wiaderko, węzły w obiekcie mapy, ich skróty i zajętość slotów:
+    BucketNode* mSmallHead;
+    unsigned mSmallUsed;
+    size_type mSmallHashes[SmallCapacity];
+    SmallSlot mSmallNodes[SmallCapacity];
+
+    bool isSmall() const
+    {
+        return mBuckets == &mSmallHead;
+    }
+
+    BucketNode* smallNode(size_type pSlot) const
+    {
+        return reinterpret_cast<BucketNode*>(const_cast<SmallSlot*>(&mSmallNodes[pSlot]));
+    }
     //Zwraca indeks wiaderka:
     size_type bucketHash(const key_type& pKey) const
     {
-        return mHasher(pKey) % mBucketCount;
+        if (isSmall())
+            return 0;
+        return mIndex(mHasher(pKey));
+    }
+    //Wyszukanie węzła w danym wiaderku:
+    BucketNode* findNode(const key_type& pKey, size_type pBucket) const
+    {
+        if (isSmall())
+            return findSmall(pKey);
+        BucketNode* node = mBuckets[pBucket];
+        while (node != nullptr && node->mPair.first != pKey)
+            node = node->mNextNode;
+        return node;
+    }
+    //Mała mapa: porównanie skrótów w pętli bez rozgałęzień (wektoryzowalnej), klucze tylko dla trafień:
+    BucketNode* findSmall(const key_type& pKey) const
+    {
+        const size_type hash = mHasher(pKey);
+        unsigned matches = 0;
+        for (unsigned i = 0; i < SmallCapacity; ++i)
+            matches |= static_cast<unsigned>(mSmallHashes[i] == hash) << i;
+        matches &= mSmallUsed;
+        for (unsigned i = 0; matches != 0; ++i, matches >>= 1)
+            if ((matches & 1u) != 0 && smallNode(i)->mPair.first == pKey)
+                return smallNode(i);
+        return nullptr;
+    }
+    static void prefetch(const void* pAddress)
+    {
+#if defined(__GNUC__)
+        __builtin_prefetch(pAddress);
+#else
+        (void)pAddress;
+#endif
+    }
+    //Początek wyszukiwania: wyznaczenie wiaderka i prefetch jego wpisu w tablicy:
+    void startLookup(Lookup& pLookup, const key_type& pKey) const
+    {
+        pLookup.mKey = &pKey;
+        pLookup.mBucket = bucketHash(pKey);
+        pLookup.mNode = nullptr;
+        pLookup.mLoaded = false;
+        pLookup.mDone = false;
+        if (isSmall())//węzły małej mapy są w obiekcie mapy - nie ma na co czekać
+        {
+            pLookup.mNode = findSmall(pKey);
+            pLookup.mDone = true;
+            return;
+        }
+        prefetch(&mBuckets[pLookup.mBucket]);
+    }
+    //Jeden krok wyszukiwania (dotyka tylko pamięci pobranej wcześniej), zwraca true po zakończeniu:
+    bool stepLookup(Lookup& pLookup) const
+    {
+        if (!pLookup.mLoaded)
+        {
+            pLookup.mNode = mBuckets[pLookup.mBucket];
+            pLookup.mLoaded = true;
+        }
+        else if (pLookup.mNode->mPair.first != *pLookup.mKey)
+            pLookup.mNode = pLookup.mNode->mNextNode;
+        else
+            return pLookup.mDone = true;
+
+        if (pLookup.mNode == nullptr)
+            return pLookup.mDone = true;
+        prefetch(pLookup.mNode);
+        return false;
+    }
+    MemoryUsage usageFor(size_type pCount, bool pSmall, size_type pBucketCount) const
+    {
+        MemoryUsage usage;
+        usage.mKeys = pCount * sizeof(key_type);
+        usage.mValues = pCount * sizeof(mapped_type);
+        usage.mNodes = pCount * sizeof(BucketNode) - usage.mKeys - usage.mValues;
+        usage.mBuckets = pSmall ? 0 : pBucketCount * sizeof(BucketNode*);
+        usage.mObject = sizeof(HashMap) - (pSmall ? pCount * sizeof(SmallSlot) : 0);
+        return usage;
+    }
+    //Sprawdzenie budżetu przed wstawieniem jednego elementu (łącznie z ewentualnym przejściem do wiaderek):
+    void checkBudget()
+    {
+        bool small = isSmall() && mCount < SmallCapacity;
+        size_type buckets = small ? mBucketCount : mIndex.bucketCount();
+        size_type expected = usageFor(mCount + 1, small, buckets).total();
+        if (expected <= mMemoryBudget)
+            return;
+        if (!mOnBudgetExceeded || !mOnBudgetExceeded(*this, expected))
+            throw std::length_error("Memory budget exceeded.");
+    }
+    //Nowy węzeł: w wolnym slocie małej mapy albo na stercie:
+    BucketNode* newNode(value_type pPair)
+    {
+        if (!isSmall())
+            return new BucketNode(pPair);
+        size_type slot = 0;
+        while ((mSmallUsed & (1u << slot)) != 0)
+            ++slot;
+        mSmallUsed |= 1u << slot;
+        mSmallHashes[slot] = mHasher(pPair.first);
+        return new (&mSmallNodes[slot]) BucketNode(pPair);
+    }
+
+    void freeNode(BucketNode* pNode)
+    {
+        if (!isSmall())
+        {
+            delete pNode;
+            return;
+        }
+        size_type slot = reinterpret_cast<SmallSlot*>(pNode) - mSmallNodes;
+        pNode->~BucketNode();
+        mSmallUsed &= ~(1u << slot);
+    }
+    //Przejście z małej mapy do tablicy wiaderek:
+    void grow()
+    {
+        BucketNode* node = mSmallHead;
+        mSmallHead = nullptr;
+        mBucketCount = mIndex.bucketCount();
+        mBuckets = new BucketNode*[mBucketCount];
+        for (size_type i = 0; i < mBucketCount; ++i)
+            mBuckets[i] = nullptr;
+        mCount = 0;
+        while (node != nullptr)
+        {
+            BucketNode* next = node->mNextNode;
+            insertNode(node->mPair.first, std::move(node->mPair.second));
+            node->~BucketNode();
+            node = next;
+        }
+        mSmallUsed = 0;
+    }
+    //Opróżnienie i powrót do trybu małej mapy:
+    void reset()
+    {
+        clear();
+        if (isSmall())
+            return;
+        delete[] mBuckets;
+        mBuckets = &mSmallHead;
+        mBucketCount = 1;
+    }
+    //Skopiowanie zawartości innej mapy do pustej mapy w trybie małym:
+    void copyFrom(const HashMap& other)
+    {
+        if (other.isSmall())
+        {
+            for (BucketNode* node = other.mSmallHead; node != nullptr; node = node->mNextNode)
+                insertNode(node->mPair.first, node->mPair.second);
+            return;
+        }
+        mBucketCount = other.mBucketCount;
+        mBuckets = new BucketNode*[mBucketCount];
+        share(other);
+    }
+    //Przeniesienie zawartości innej mapy do pustej mapy w trybie małym:
+    void takeFrom(HashMap& other)
+    {
+        if (other.isSmall())
+        {
+            for (BucketNode* node = other.mSmallHead; node != nullptr; node = node->mNextNode)
+                insertNode(node->mPair.first, std::move(node->mPair.second));
+            other.clear();
+            return;
+        }
+        std::swap(mBuckets, other.mBuckets);
+        std::swap(mBucketCount, other.mBucketCount);
+        std::swap(mCount, other.mCount);
+        other.mBuckets = &other.mSmallHead;
     }
 
     size_type hash(const key_type& pKey) const
@@ -262,11 +693,24 @@ private:
     }
 
     iterator insert(const key_type& pKey, mapped_type pValue)
+    {
+        if (mMemoryBudget != 0)
+            checkBudget();
+        if (isSmall() && mCount == SmallCapacity)
+            grow();
+        return insertNode(pKey, std::move(pValue));
+    };
+    //Wstawienie bez sprawdzania budżetu i bez zmiany trybu (przenoszenie istniejących elementów):
+    iterator insertNode(const key_type& pKey, mapped_type pValue)
     {
         size_type bucket = bucketHash(pKey);//które wiaderko
-        BucketNode* temp = new BucketNode(pKey, pValue);
+        makeUnique(bucket);
+        BucketNode* temp = newNode(value_type(pKey, std::move(pValue)));
         if (mBuckets[bucket] != nullptr)
+        {
             temp->mNextNode = mBuckets[bucket];
+            mBuckets[bucket]->mPrevNode = temp;
+        }
         mBuckets[bucket] = temp;//wstawianie na początek wiaderka
         ++mCount;
         return Iterator(*this, bucket, temp);
@@ -274,50 +718,96 @@ private:
 
     iterator insert(const key_type& pKey)
     {
-        size_type bucket = bucketHash(pKey);
-        BucketNode* temp = new BucketNode(pKey);
-        if (mBuckets[bucket] != nullptr)
-            temp->mNextNode = mBuckets[bucket];
-        mBuckets[bucket] = temp;
-        ++mCount;
-        return Iterator(*this, bucket, temp);
+        return insert(pKey, mapped_type {});
     };
-    //Usuwanie wszystkich rekordów:
+    //Wypięcie węzła z listy wiaderka i jego zwolnienie:
+    void unlink(size_type pBucket, BucketNode* pNode)
+    {
+        if (pNode->mPrevNode != nullptr)
+            pNode->mPrevNode->mNextNode = pNode->mNextNode;
+        else
+            mBuckets[pBucket] = pNode->mNextNode;
+        if (pNode->mNextNode != nullptr)
+            pNode->mNextNode->mPrevNode = pNode->mPrevNode;
+        freeNode(pNode);
+        --mCount;
+    }
+    //Usuwanie wszystkich rekordów (współdzielone łańcuchy zostają u pozostałych właścicieli):
     void clear()
     {
-        BucketNode* node;
-        BucketNode* temp;
-
+        if (isSmall())
+        {
+            while (mSmallHead != nullptr)
+                unlink(0, mSmallHead);
+            return;
+        }
         for (size_type i = 0; i < mBucketCount; ++i)
         {
-            node = mBuckets[i];
-            while (node != nullptr)
-            {
-                temp = node;
-                node = node->mNextNode;
-                delete temp;
-                --mCount;
-            }
+            if (mBuckets[i] != nullptr)
+                releaseChain(mBuckets[i]);
             mBuckets[i] = nullptr;
         }
+        mCount = 0;
     };
-};
+    //Przejęcie (współdzielenie) wszystkich łańcuchów innej mapy o tej samej liczbie wiaderek:
+    void share(const HashMap& other)
+    {
+        for (size_type i = 0; i < mBucketCount; ++i)
+        {
+            mBuckets[i] = other.mBuckets[i];
+            if (mBuckets[i] != nullptr)
+                ++mBuckets[i]->mRefs;
+        }
+        mCount = other.mCount;
+    }
+    //Porzucenie łańcucha; ostatni właściciel zwalnia węzły:
+    void releaseChain(BucketNode* pHead)
+    {
+        if (--pHead->mRefs != 0)
+            return;
+        while (pHead != nullptr)
+        {
+            BucketNode* temp = pHead;
+            pHead = pHead->mNextNode;
+            delete temp;
+        }
+    }
+    //Kopiowanie współdzielonego łańcucha przed zapisem; zwraca odpowiednik pNode w nowym łańcuchu:
+    BucketNode* makeUnique(size_type pBucket, BucketNode* pNode = nullptr)
+    {
+        BucketNode* head = mBuckets[pBucket];
+        if (head == nullptr || head->mRefs == 1)
+            return pNode;
 
-//Pojedynczy "węzeł" hashmapy:
-template<typename KeyType, typename ValueType>
-struct HashMap<KeyType, ValueType>::BucketNode
-{   //Para klucz/wartość:
-    value_type mPair;
-    //Wskaźnik na następny węzeł w wiaderku:
-    BucketNode* mNextNode;
-    //Konstruktory:
-    BucketNode(const key_type& pKey) : mPair(std::make_pair(pKey, ValueType {})), mNextNode(nullptr) {}
-    BucketNode(const key_type& pKey, mapped_type pData) : mPair(std::make_pair(pKey, pData)), mNextNode(nullptr) {}
-    BucketNode(value_type pPair) : mPair(pPair), mNextNode(nullptr) {}
+        BucketNode* copyHead = nullptr;
+        BucketNode* tail = nullptr;
+        BucketNode* result = nullptr;
+        for (BucketNode* node = head; node != nullptr; node = node->mNextNode)
+        {
+            BucketNode* copy = new BucketNode(node->mPair);
+            copy->mPrevNode = tail;
+            if (tail != nullptr)
+                tail->mNextNode = copy;
+            else
+                copyHead = copy;
+            tail = copy;
+            if (node == pNode)
+                result = copy;
+        }
+        mBuckets[pBucket] = copyHead;
+        releaseChain(head);
+        return result;
+    }
 };
 
-template <typename KeyType, typename ValueType>
-class HashMap<KeyType, ValueType>::ConstIterator
+template <typename KeyType, typename ValueType, typename IndexPolicy>
+const typename HashMap<KeyType, ValueType, IndexPolicy>::size_type HashMap<KeyType, ValueType, IndexPolicy>::SmallCapacity;
+
+template <typename KeyType, typename ValueType, typename IndexPolicy>
+const typename HashMap<KeyType, ValueType, IndexPolicy>::size_type HashMap<KeyType, ValueType, IndexPolicy>::LookupGroupSize;
+
+template <typename KeyType, typename ValueType, typename IndexPolicy>
+class HashMap<KeyType, ValueType, IndexPolicy>::ConstIterator
 {
 public:
     using reference = typename HashMap::const_reference;
@@ -327,13 +817,13 @@ public:
 
     friend class HashMap;
 
-    explicit ConstIterator(const HashMap<KeyType, ValueType>& Map, size_type Bucket, BucketNode* Node) : mMap(
-            Map), mBucket(Bucket), mNode(Node)
+    explicit ConstIterator(const HashMap& Map, size_type Bucket, BucketNode* Node) : mMap(
+            &Map), mBucket(Bucket), mNode(Node)
     {
-            while (mNode == nullptr && mBucket < mMap.mBucketCount - 1)
+            while (mNode == nullptr && mBucket < mMap->mBucketCount - 1)
         {
             ++mBucket;
-            mNode = mMap.mBuckets[mBucket];
+            mNode = mMap->mBuckets[mBucket];
         }
     }
 
@@ -345,10 +835,10 @@ public:
             throw std::out_of_range("Cannot increment end.");
 
         mNode = mNode->mNextNode;
-        while (mNode == nullptr && mBucket < mMap.mBucketCount - 1)
+        while (mNode == nullptr && mBucket < mMap->mBucketCount - 1)
         {
             ++mBucket;
-            mNode = mMap.mBuckets[mBucket];
+            mNode = mMap->mBuckets[mBucket];
         }
 
         return *this;
@@ -363,23 +853,21 @@ public:
 
     ConstIterator& operator--()
     {
-        if (mMap.mBuckets[mBucket] == mNode)
+        if (mNode != nullptr && mNode->mPrevNode != nullptr)
         {
-            while (mMap.mBuckets[mBucket] == nullptr && mBucket > 0) mBucket--;
-            mNode = mMap.mBuckets[mBucket];
-
-            if (mBucket < 0 || mNode == nullptr)
-                throw std::out_of_range("Cannot decrement beginning.");
+            mNode = mNode->mPrevNode;
+            return *this;
+        }
+        //Szukanie poprzedniego niepustego wiaderka (dla end() także bieżącego):
+        size_type bucket = (mNode == nullptr) ? mBucket + 1 : mBucket;
+        while (bucket > 0 && mMap->mBuckets[bucket - 1] == nullptr) --bucket;
 
-            while (mNode->mNextNode != nullptr) mNode = mNode->mNextNode;
+        if (bucket == 0)
+            throw std::out_of_range("Cannot decrement beginning.");
 
-        }
-        else
-        {
-            BucketNode* node = mMap.mBuckets[mBucket];
-            while (node->mNextNode != mNode) node = node->mNextNode;
-            mNode = node;
-        }
+        mBucket = bucket - 1;
+        mNode = mMap->mBuckets[mBucket];
+        while (mNode->mNextNode != nullptr) mNode = mNode->mNextNode;
         return *this;
     }
 
@@ -413,48 +901,60 @@ public:
     }
 
 private:
-    const HashMap& mMap;
+    const HashMap* mMap;//wskaźnik, aby iterator dało się przypisywać (it = map.erase(it))
     size_type mBucket;
     BucketNode* mNode;
 };
 
-template <typename KeyType, typename ValueType>
-class HashMap<KeyType, ValueType>::Iterator : public HashMap<KeyType, ValueType>::ConstIterator
+template <typename KeyType, typename ValueType, typename IndexPolicy>
+class HashMap<KeyType, ValueType, IndexPolicy>::Iterator : public HashMap<KeyType, ValueType, IndexPolicy>::ConstIterator
 {
 public:
     using reference = typename HashMap::reference;
     using pointer = typename HashMap::value_type*;
 
-    explicit Iterator(const HashMap<KeyType, ValueType>& Map, size_type Bucket, BucketNode* Node)
-        : ConstIterator(Map, Bucket, Node) {}
+    explicit Iterator(const HashMap& Map, size_type Bucket, BucketNode* Node)
+        : ConstIterator(Map, Bucket, Node)
+    {
+        unshare();
+    }
 
     Iterator(const ConstIterator& other)
         : ConstIterator(other)
-    {}
+    {
+        unshare();
+    }
 
     Iterator& operator++()
     {
+        size_type bucket = this->mBucket;
         ConstIterator::operator++();
+        if (this->mBucket != bucket)
+            unshare();
         return *this;
     }
 
     Iterator operator++(int)
     {
         auto result = *this;
-        ConstIterator::operator++();
+        operator++();
         return result;
     }
 
     Iterator& operator--()
     {
+        size_type bucket = this->mBucket;
+        BucketNode* node = this->mNode;
         ConstIterator::operator--();
+        if (this->mBucket != bucket || node == nullptr)
+            unshare();
         return *this;
     }
 
     Iterator operator--(int)
     {
         auto result = *this;
-        ConstIterator::operator--();
+        operator--();
         return result;
     }
 
@@ -468,6 +968,15 @@ public:
         // ugly cast, yet reduces code duplication.
         return const_cast<reference>(ConstIterator::operator*());
     }
+
+private:
+    //Zapis przez iterator nie może zmienić migawki - wiaderko współdzielone z nią jest kopiowane
+    //przy wejściu iteratora (w obrębie wiaderka węzły są już własne):
+    void unshare()
+    {
+        if (this->mNode != nullptr)
+            this->mNode = const_cast<HashMap*>(this->mMap)->makeUnique(this->mBucket, this->mNode);
+    }
 };
 
 }
@@ -0,0 +1,366 @@
+#ifndef AISDI_MAPS_PERSISTENTTREEMAP_H
+#define AISDI_MAPS_PERSISTENTTREEMAP_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace aisdi {
+
+    //Trwała (persistent) wersja drzewa AVL: węzły są niezmienne i współdzielone przez wersje,
+    //a każda zmiana kopiuje tylko ścieżkę od korzenia do zmienianego miejsca (O(log n) nowych węzłów).
+    //Węzły nie mają wskaźników na rodzica (węzeł może mieć wielu rodziców w różnych wersjach),
+    //a ich czas życia wyznacza atomowy licznik referencji. snapshot() kosztuje O(1); wersję można
+    //czytać z innych wątków równolegle ze zmianami innych wersji (sam obiekt mapy nie jest synchronizowany).
+    //Wartości są niezmienne - nie ma operator[] ani iteratora modyfikującego, zmiany tylko przez insert/remove.
+    template<typename KeyType, typename ValueType, typename Compare = std::less<KeyType>>
+    class PersistentTreeMap {
+    public:
+        using key_type = KeyType;
+        using key_compare = Compare;
+        using mapped_type = ValueType;
+        using value_type = std::pair<const key_type, mapped_type>;
+        using size_type = std::size_t;
+        using const_reference = const value_type&;
+
+        class ConstIterator;
+
+        class TreeNode;
+
+        using const_iterator = ConstIterator;
+        using iterator = ConstIterator;
+
+        PersistentTreeMap() : PersistentTreeMap(Compare()) {}
+
+        explicit PersistentTreeMap(const Compare& pCompare) : mRoot(nullptr), mCount(0), mCompare(pCompare) {}
+
+        PersistentTreeMap(std::initializer_list<value_type> list) : PersistentTreeMap() {
+            for (auto&& item : list)
+                insert(item.first, item.second);
+        }
+        //Kopia to współdzielenie korzenia - O(1):
+        PersistentTreeMap(const PersistentTreeMap& other) : mRoot(retain(other.mRoot)), mCount(other.mCount),
+                                                            mCompare(other.mCompare) {}
+
+        PersistentTreeMap(PersistentTreeMap&& other) : mRoot(other.mRoot), mCount(other.mCount),
+                                                       mCompare(other.mCompare) {
+            other.mRoot = nullptr;
+            other.mCount = 0;
+        }
+
+        ~PersistentTreeMap() {
+            release(mRoot);
+        }
+
+        PersistentTreeMap& operator=(const PersistentTreeMap& other) {
+            const TreeNode* root = retain(other.mRoot);
+            release(mRoot);
+            mRoot = root;
+            mCount = other.mCount;
+            mCompare = other.mCompare;
+            return *this;
+        }
+
+        PersistentTreeMap& operator=(PersistentTreeMap&& other) {
+            if (this == &other)
+                return *this;
+            release(mRoot);
+            mRoot = other.mRoot;
+            mCount = other.mCount;
+            mCompare = other.mCompare;
+            other.mRoot = nullptr;
+            other.mCount = 0;
+            return *this;
+        }
+        //Niezmienny widok bieżącej wersji (dalsze zmiany tej mapy go nie dotyczą):
+        PersistentTreeMap snapshot() const {
+            return *this;
+        }
+
+        bool isEmpty() const {
+            return mCount == 0;
+        }
+
+        size_type getSize() const {
+            return mCount;
+        }
+        //Wstawienie albo nadpisanie wartości - nowa ścieżka, stare wersje bez zmian:
+        void insert(const key_type& key, const mapped_type& value) {
+            bool added = false;
+            const TreeNode* root = insertInto(mRoot, key, value, added);
+            release(mRoot);
+            mRoot = root;
+            if (added)
+                ++mCount;
+        }
+
+        void remove(const key_type& key) {
+            if (findNode(key) == nullptr)
+                throw std::out_of_range("Node not found.");
+            const TreeNode* root = removeFrom(mRoot, key);
+            release(mRoot);
+            mRoot = root;
+            --mCount;
+        }
+
+        const mapped_type& valueOf(const key_type& key) const {
+            const TreeNode* node = findNode(key);
+            if (node == nullptr)
+                throw std::out_of_range("Key not found.");
+            return node->mPair.second;
+        }
+        //Iterator trzyma stos przodków, do których jeszcze wróci (zejście w lewo), i sam węzeł:
+        const_iterator find(const key_type& key) const {
+            ConstIterator it;
+            for (const TreeNode* node = mRoot; node != nullptr;) {
+                if (mCompare(key, node->mPair.first)) {
+                    it.mPath.push_back(node);
+                    node = node->mLeft;
+                } else if (mCompare(node->mPair.first, key)) {
+                    node = node->mRight;
+                } else {
+                    it.mPath.push_back(node);
+                    return it;
+                }
+            }
+            return end();
+        }
+
+        bool operator==(const PersistentTreeMap& other) const {
+            if (mCount != other.mCount)
+                return false;
+            if (mRoot == other.mRoot)
+                return true;
+
+            for (auto&& item : other) {
+                const TreeNode* node = findNode(item.first);
+                if (node == nullptr || node->mPair.second != item.second)
+                    return false;
+            }
+
+            return true;
+        }
+
+        bool operator!=(const PersistentTreeMap& other) const {
+            return !(*this == other);
+        }
+
+        const_iterator begin() const {
+            ConstIterator it;
+            it.pushLeftSpine(mRoot);
+            return it;
+        }
+
+        const_iterator end() const {
+            return ConstIterator();
+        }
+
+        const_iterator cbegin() const {
+            return begin();
+        }
+
+        const_iterator cend() const {
+            return end();
+        }
+
+    private:
+        const TreeNode* mRoot;
+        size_type mCount;
+        Compare mCompare;
+
+        const TreeNode* findNode(const key_type& pKey) const {
+            const TreeNode* node = mRoot;
+            while (node != nullptr) {
+                if (mCompare(pKey, node->mPair.first))
+                    node = node->mLeft;
+                else if (mCompare(node->mPair.first, pKey))
+                    node = node->mRight;
+                else
+                    return node;
+            }
+            return nullptr;
+        }
+        //Zwracane węzły należą do wołającego (jedna referencja); pNode pozostaje własnością starej wersji.
+        const TreeNode* insertInto(const TreeNode* pNode, const key_type& pKey, const mapped_type& pValue,
+                                   bool& pAdded) const {
+            if (pNode == nullptr) {
+                pAdded = true;
+                return makeNode(value_type(pKey, pValue), nullptr, nullptr);
+            }
+            if (mCompare(pKey, pNode->mPair.first))
+                return balance(pNode->mPair, insertInto(pNode->mLeft, pKey, pValue, pAdded), retain(pNode->mRight));
+            if (mCompare(pNode->mPair.first, pKey))
+                return balance(pNode->mPair, retain(pNode->mLeft), insertInto(pNode->mRight, pKey, pValue, pAdded));
+            return makeNode(value_type(pNode->mPair.first, pValue), retain(pNode->mLeft), retain(pNode->mRight));
+        }
+        //Klucz musi być w poddrzewie (sprawdzane w remove):
+        const TreeNode* removeFrom(const TreeNode* pNode, const key_type& pKey) const {
+            if (mCompare(pKey, pNode->mPair.first))
+                return balance(pNode->mPair, removeFrom(pNode->mLeft, pKey), retain(pNode->mRight));
+            if (mCompare(pNode->mPair.first, pKey))
+                return balance(pNode->mPair, retain(pNode->mLeft), removeFrom(pNode->mRight, pKey));
+            if (pNode->mLeft == nullptr)
+                return retain(pNode->mRight);
+            if (pNode->mRight == nullptr)
+                return retain(pNode->mLeft);
+            //Dwoje dzieci - miejsce usuwanego zajmuje najmniejszy element prawego poddrzewa:
+            const TreeNode* next = pNode->mRight;
+            while (next->mLeft != nullptr)
+                next = next->mLeft;
+            return balance(next->mPair, retain(pNode->mLeft), removeFirst(pNode->mRight));
+        }
+
+        static const TreeNode* removeFirst(const TreeNode* pNode) {
+            if (pNode->mLeft == nullptr)
+                return retain(pNode->mRight);
+            return balance(pNode->mPair, removeFirst(pNode->mLeft), retain(pNode->mRight));
+        }
+        //Nowy węzeł przejmuje referencje pLeft i pRight:
+        static const TreeNode* makeNode(const value_type& pPair, const TreeNode* pLeft, const TreeNode* pRight) {
+            return new TreeNode(pPair, pLeft, pRight);
+        }
+        //Węzeł z pPair nad pLeft i pRight (przejmowanymi), z rotacją, gdy wysokości różnią się o 2.
+        //Rotacje tworzą nowe węzły zamiast przepinać stare - te mogą należeć do innych wersji:
+        static const TreeNode* balance(const value_type& pPair, const TreeNode* pLeft, const TreeNode* pRight) {
+            int difference = getHeight(pLeft) - getHeight(pRight);
+            if (difference > 1)
+                return rotateRight(pPair, pLeft, pRight);
+            if (difference < -1)
+                return rotateLeft(pPair, pLeft, pRight);
+            return makeNode(pPair, pLeft, pRight);
+        }
+        //Lewe poddrzewo za wysokie (pojedyncza albo podwójna rotacja w prawo):
+        static const TreeNode* rotateRight(const value_type& pPair, const TreeNode* pLeft, const TreeNode* pRight) {
+            const TreeNode* result;
+            if (getHeight(pLeft->mLeft) >= getHeight(pLeft->mRight)) {
+                result = makeNode(pLeft->mPair, retain(pLeft->mLeft), makeNode(pPair, retain(pLeft->mRight), pRight));
+            } else {
+                const TreeNode* middle = pLeft->mRight;
+                result = makeNode(middle->mPair, makeNode(pLeft->mPair, retain(pLeft->mLeft), retain(middle->mLeft)),
+                                  makeNode(pPair, retain(middle->mRight), pRight));
+            }
+            release(pLeft);
+            return result;
+        }
+        //Prawe poddrzewo za wysokie (lustrzane odbicie rotateRight):
+        static const TreeNode* rotateLeft(const value_type& pPair, const TreeNode* pLeft, const TreeNode* pRight) {
+            const TreeNode* result;
+            if (getHeight(pRight->mRight) >= getHeight(pRight->mLeft)) {
+                result = makeNode(pRight->mPair, makeNode(pPair, pLeft, retain(pRight->mLeft)), retain(pRight->mRight));
+            } else {
+                const TreeNode* middle = pRight->mLeft;
+                result = makeNode(middle->mPair, makeNode(pPair, pLeft, retain(middle->mLeft)),
+                                  makeNode(pRight->mPair, retain(middle->mRight), retain(pRight->mRight)));
+            }
+            release(pRight);
+            return result;
+        }
+
+        static int getHeight(const TreeNode* pNode) {
+            return pNode == nullptr ? 0 : pNode->mHeight;
+        }
+
+        static const TreeNode* retain(const TreeNode* pNode) {
+            if (pNode != nullptr)
+                pNode->mReferences.fetch_add(1, std::memory_order_relaxed);
+            return pNode;
+        }
+        //Zwolnienie referencji; ostatnia usuwa węzeł i zwalnia jego dzieci (głębokość rekursji to wysokość drzewa).
+        //acq_rel porządkuje wcześniejsze odczyty węzła w innych wątkach przed jego usunięciem:
+        static void release(const TreeNode* pNode) {
+            if (pNode == nullptr || pNode->mReferences.fetch_sub(1, std::memory_order_acq_rel) != 1)
+                return;
+            const TreeNode* left = pNode->mLeft;
+            const TreeNode* right = pNode->mRight;
+            delete pNode;
+            release(left);
+            release(right);
+        }
+    };
+
+    template<typename KeyType, typename ValueType, typename Compare>
+    class PersistentTreeMap<KeyType, ValueType, Compare>::TreeNode {
+    public:
+        value_type mPair;//para klucz porządkujący/wartość
+        const TreeNode* mLeft;//wskaźnik na lewego potomka (współdzielony)
+        const TreeNode* mRight;//wskaźnik na prawego potomka (współdzielony)
+        mutable std::atomic<std::uint32_t> mReferences;//liczba rodziców i wersji wskazujących węzeł
+        std::int8_t mHeight;//wysokość węzła (liść ma 1)
+
+        TreeNode(const value_type& pPair, const TreeNode* pLeft, const TreeNode* pRight)
+                : mPair(pPair), mLeft(pLeft), mRight(pRight), mReferences(1),
+                  mHeight(static_cast<std::int8_t>(1 + std::max(getHeight(pLeft), getHeight(pRight)))) {}
+
+    private:
+        static int getHeight(const TreeNode* pNode) {
+            return pNode == nullptr ? 0 : pNode->mHeight;
+        }
+    };
+
+    //Iterator jednokierunkowy: bez wskaźników na rodzica ścieżka w górę jest trzymana w iteratorze.
+    //Ważny, dopóki istnieje wersja, z której pochodzi (węzły nie są przez niego podtrzymywane).
+    template<typename KeyType, typename ValueType, typename Compare>
+    class PersistentTreeMap<KeyType, ValueType, Compare>::ConstIterator {
+    public:
+        using reference = typename PersistentTreeMap::const_reference;
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = typename PersistentTreeMap::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const typename PersistentTreeMap::value_type*;
+
+        friend class PersistentTreeMap;
+
+        ConstIterator() {}
+
+        ConstIterator& operator++() {
+            if (mPath.empty())
+                throw std::out_of_range("End of tree.");
+            const TreeNode* node = mPath.back();
+            mPath.pop_back();
+            pushLeftSpine(node->mRight);
+            return *this;
+        }
+
+        ConstIterator operator++(int) {
+            ConstIterator temp(*this);
+            operator++();
+            return temp;
+        }
+
+        reference operator*() const {
+            if (mPath.empty())
+                throw std::out_of_range("Dereferencing used iterator");
+            return mPath.back()->mPair;
+        }
+
+        pointer operator->() const {
+            return &this->operator*();
+        }
+
+        bool operator==(const ConstIterator& other) const {
+            return mPath.empty() ? other.mPath.empty() : !other.mPath.empty() && mPath.back() == other.mPath.back();
+        }
+
+        bool operator!=(const ConstIterator& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        std::vector<const TreeNode*> mPath;//przodkowie do odwiedzenia (od korzenia), na końcu bieżący węzeł
+
+        void pushLeftSpine(const TreeNode* pNode) {
+            for (; pNode != nullptr; pNode = pNode->mLeft)
+                mPath.push_back(pNode);
+        }
+    };
+
+}
+
+#endif /* AISDI_MAPS_PERSISTENTTREEMAP_H */
@@ -0,0 +1,995 @@
+#ifndef AISDI_MAPS_RADIXTREEMAP_H
+#define AISDI_MAPS_RADIXTREEMAP_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace aisdi {
+
+    //Rozkład klucza na bajty: porządek leksykograficzny bajtów musi być zgodny z operatorem < kluczy.
+    //Własne typy kluczy - przez specjalizację (size i byteAt).
+    template<typename KeyType, typename Enable = void>
+    struct RadixKeyTraits;
+
+    //Liczby całkowite: bajty od najstarszego, w typach ze znakiem z odwróconym bitem znaku (ujemne przed dodatnimi):
+    template<typename KeyType>
+    struct RadixKeyTraits<KeyType, typename std::enable_if<std::is_integral<KeyType>::value &&
+                                                           !std::is_same<KeyType, bool>::value>::type> {
+        using Bits = typename std::make_unsigned<KeyType>::type;
+
+        static std::size_t size(const KeyType&) {
+            return sizeof(KeyType);
+        }
+
+        static unsigned char byteAt(const KeyType& pKey, std::size_t pIndex) {
+            Bits bits = static_cast<Bits>(pKey);
+            if (std::is_signed<KeyType>::value)
+                bits = static_cast<Bits>(bits ^ (Bits(1) << (8 * sizeof(KeyType) - 1)));
+            return static_cast<unsigned char>(bits >> (8 * (sizeof(KeyType) - 1 - pIndex)));
+        }
+    };
+
+    //Napisy: kolejne znaki jako bajty bez znaku (tak samo porównuje std::string):
+    template<>
+    struct RadixKeyTraits<std::string> {
+        static std::size_t size(const std::string& pKey) {
+            return pKey.size();
+        }
+
+        static unsigned char byteAt(const std::string& pKey, std::size_t pIndex) {
+            return static_cast<unsigned char>(pKey[pIndex]);
+        }
+    };
+
+    //Słownik uporządkowany oparty o adaptacyjne drzewo pozycyjne (ART) - ten sam interfejs co TreeMap.
+    //Zejście wybiera dziecko po kolejnym bajcie klucza zamiast porównywać całe klucze; węzły mają 4, 16,
+    //48 albo 256 dzieci zależnie od wypełnienia, a ścieżki bez rozgałęzień są skompresowane do prefiksu węzła.
+    //Elementy leżą w liściach połączonych listą w porządku kluczy (iteracja i przedziały bez chodzenia po drzewie).
+    template<typename KeyType, typename ValueType, typename KeyTraits = RadixKeyTraits<KeyType>>
+    class RadixTreeMap {
+    public:
+        using key_type = KeyType;
+        using mapped_type = ValueType;
+        using value_type = std::pair<const key_type, mapped_type>;
+        using size_type = std::size_t;
+        using reference = value_type&;
+        using const_reference = const value_type&;
+
+        class ConstIterator;
+
+        class Iterator;
+
+        using iterator = Iterator;
+        using const_iterator = ConstIterator;
+
+        RadixTreeMap() : mRoot(nullptr), mHead(nullptr), mTail(nullptr), mCount(0) {}
+
+        RadixTreeMap(std::initializer_list<value_type> list) : RadixTreeMap() {
+            for (auto&& item : list)
+                (*this)[item.first] = item.second;
+        }
+
+        RadixTreeMap(const RadixTreeMap& other) : RadixTreeMap() {
+            for (auto&& item : other)
+                (*this)[item.first] = item.second;
+        }
+
+        RadixTreeMap(RadixTreeMap&& other) : RadixTreeMap() {
+            swap(other);
+        }
+
+        ~RadixTreeMap() {
+            clear();
+        }
+
+        RadixTreeMap& operator=(const RadixTreeMap& other) {
+            if (this == &other)
+                return *this;
+            clear();
+            for (auto&& item : other)
+                (*this)[item.first] = item.second;
+            return *this;
+        }
+
+        RadixTreeMap& operator=(RadixTreeMap&& other) {
+            if (this == &other)
+                return *this;
+            clear();
+            swap(other);
+            return *this;
+        }
+
+        bool isEmpty() const {
+            return mCount == 0;
+        }
+
+        mapped_type& operator[](const key_type& key) {
+            Leaf* leaf = findLeaf(key);//istniejący klucz - bez ścieżki wstawiania
+            if (leaf == nullptr)
+                leaf = insert(mRoot, key, 0);
+            return leaf->mPair.second;
+        }
+
+        const mapped_type& valueOf(const key_type& key) const {
+            Leaf* leaf = findLeaf(key);
+            if (leaf == nullptr)
+                throw std::out_of_range("Key not found.");
+            return leaf->mPair.second;
+        }
+
+        mapped_type& valueOf(const key_type& key) {
+            return const_cast<mapped_type&>(static_cast<const RadixTreeMap*>(this)->valueOf(key));
+        }
+
+        const_iterator find(const key_type& key) const {
+            return ConstIterator(*this, findLeaf(key));
+        }
+
+        iterator find(const key_type& key) {
+            return static_cast<const RadixTreeMap*>(this)->find(key);
+        }
+
+        void remove(const key_type& key) {
+            if (!erase(mRoot, key, 0))
+                throw std::out_of_range("Node not found.");
+        }
+
+        void remove(const const_iterator& it) {
+            if (it == end())
+                throw std::out_of_range("Removing end iterator");
+            remove(it->first);
+        }
+
+        size_type getSize() const {
+            return mCount;
+        }
+        //Pierwszy element o kluczu >= key (end, gdy brak):
+        const_iterator lowerBound(const key_type& key) const {
+            return ConstIterator(*this, lowerBoundLeaf(key));
+        }
+
+        iterator lowerBound(const key_type& key) {
+            return static_cast<const RadixTreeMap*>(this)->lowerBound(key);
+        }
+        //Pierwszy element o kluczu > key:
+        const_iterator upperBound(const key_type& key) const {
+            Leaf* leaf = lowerBoundLeaf(key);
+            if (leaf != nullptr && leaf->mPair.first == key)
+                leaf = leaf->mNext;
+            return ConstIterator(*this, leaf);
+        }
+
+        iterator upperBound(const key_type& key) {
+            return static_cast<const RadixTreeMap*>(this)->upperBound(key);
+        }
+
+        std::pair<const_iterator, const_iterator> equalRange(const key_type& key) const {
+            return std::make_pair(lowerBound(key), upperBound(key));
+        }
+
+        std::pair<iterator, iterator> equalRange(const key_type& key) {
+            return std::make_pair(lowerBound(key), upperBound(key));
+        }
+        //Wywołanie pFunction dla elementów o kluczach z przedziału [lo, hi) w kolejności kluczy - O(|klucz| + k):
+        template<typename Function>
+        void forEachInRange(const key_type& lo, const key_type& hi, Function pFunction) const {
+            for (Leaf* leaf = lowerBoundLeaf(lo); leaf != nullptr && leaf->mPair.first < hi; leaf = leaf->mNext)
+                pFunction(static_cast<const_reference>(leaf->mPair));
+        }
+
+        template<typename Function>
+        void forEachInRange(const key_type& lo, const key_type& hi, Function pFunction) {
+            for (Leaf* leaf = lowerBoundLeaf(lo); leaf != nullptr && leaf->mPair.first < hi; leaf = leaf->mNext)
+                pFunction(leaf->mPair);
+        }
+
+        bool operator==(const RadixTreeMap& other) const {
+            if (mCount != other.mCount)
+                return false;
+            //Obie mapy są uporządkowane - wystarczy porównać kolejne elementy:
+            for (auto it = begin(), otherIt = other.begin(); it != end(); ++it, ++otherIt)
+                if (it->first != otherIt->first || it->second != otherIt->second)
+                    return false;
+            return true;
+        }
+
+        bool operator!=(const RadixTreeMap& other) const {
+            return !(*this == other);
+        }
+
+        iterator begin() {
+            return cbegin();
+        }
+
+        iterator end() {
+            return cend();
+        }
+
+        const_iterator cbegin() const {
+            return ConstIterator(*this, mHead);
+        }
+
+        const_iterator cend() const {
+            return ConstIterator(*this, nullptr);
+        }
+
+        const_iterator begin() const {
+            return cbegin();
+        }
+
+        const_iterator end() const {
+            return cend();
+        }
+
+    private:
+        //Liczba bajtów prefiksu trzymanych w węźle; dłuższy prefiks jest sprawdzany dopiero w liściu
+        //(przy wyszukiwaniu) albo odczytywany z dowolnego liścia poddrzewa (przy zmianach):
+        static const size_type MaxPrefix = 10;
+
+        enum NodeType : std::uint8_t {
+            LeafType, Node4Type, Node16Type, Node48Type, Node256Type
+        };
+
+        struct Node {
+            NodeType mType;
+
+            explicit Node(NodeType pType) : mType(pType) {}
+        };
+
+        struct Leaf : Node {
+            value_type mPair;
+            Leaf* mPrev;//poprzedni element w porządku kluczy
+            Leaf* mNext;//następny element
+
+            explicit Leaf(const key_type& pKey) : Node(LeafType), mPair(pKey, mapped_type()), mPrev(nullptr),
+                                                  mNext(nullptr) {}
+        };
+        //Węzeł wewnętrzny: klucze poddrzewa mają wspólny prefiks, a następny bajt wybiera dziecko.
+        //Klucz kończący się zaraz po prefiksie (krótszy od pozostałych) jest w mValue.
+        //Węzeł ma zawsze co najmniej dwa wpisy (dzieci i mValue) - jeden wpis jest wciągany do rodzica.
+        struct Inner : Node {
+            std::uint16_t mCount;//liczba dzieci
+            std::uint32_t mPrefixLength;
+            unsigned char mPrefix[MaxPrefix];//pierwsze bajty prefiksu
+            Leaf* mValue;
+
+            explicit Inner(NodeType pType) : Node(pType), mCount(0), mPrefixLength(0), mValue(nullptr) {}
+        };
+        //Węzły 4 i 16: bajty dzieci posortowane, dziecko i odpowiada bajtowi mKeys[i]:
+        template<int Capacity, NodeType Type>
+        struct SortedNode : Inner {
+            unsigned char mKeys[Capacity];
+            Node* mChildren[Capacity];
+
+            SortedNode() : Inner(Type) {
+                std::fill(mKeys, mKeys + Capacity, 0);
+            }
+        };
+
+        using Node4 = SortedNode<4, Node4Type>;
+        using Node16 = SortedNode<16, Node16Type>;
+        //Węzeł 48: mIndex[bajt] to pozycja dziecka + 1 (0 - brak dziecka):
+        struct Node48 : Inner {
+            unsigned char mIndex[256];
+            Node* mChildren[48];
+
+            Node48() : Inner(Node48Type) {
+                std::fill(mIndex, mIndex + 256, 0);
+                std::fill(mChildren, mChildren + 48, nullptr);
+            }
+        };
+
+        struct Node256 : Inner {
+            Node* mChildren[256];
+
+            Node256() : Inner(Node256Type) {
+                std::fill(mChildren, mChildren + 256, nullptr);
+            }
+        };
+
+        Node* mRoot;
+        Leaf* mHead;//najmniejszy klucz (begin)
+        Leaf* mTail;//największy klucz (dla --end)
+        size_type mCount;
+
+        static unsigned char byteAt(const key_type& pKey, size_type pIndex) {
+            return KeyTraits::byteAt(pKey, pIndex);
+        }
+
+        static size_type keySize(const key_type& pKey) {
+            return KeyTraits::size(pKey);
+        }
+
+        void swap(RadixTreeMap& other) {
+            std::swap(mRoot, other.mRoot);
+            std::swap(mHead, other.mHead);
+            std::swap(mTail, other.mTail);
+            std::swap(mCount, other.mCount);
+        }
+        //Wyszukanie optymistyczne: z prefiksów porównywane są tylko zapamiętane bajty, pełny klucz - w liściu:
+        Leaf* findLeaf(const key_type& pKey) const {
+            size_type depth = 0;
+            size_type size = keySize(pKey);
+            for (Node* node = mRoot; node != nullptr;) {
+                if (node->mType == LeafType) {
+                    Leaf* leaf = static_cast<Leaf*>(node);
+                    return leaf->mPair.first == pKey ? leaf : nullptr;
+                }
+                Inner* inner = static_cast<Inner*>(node);
+                if (depth + inner->mPrefixLength > size)
+                    return nullptr;
+                size_type stored = std::min<size_type>(inner->mPrefixLength, MaxPrefix);
+                for (size_type i = 0; i < stored; ++i)
+                    if (inner->mPrefix[i] != byteAt(pKey, depth + i))
+                        return nullptr;
+                depth += inner->mPrefixLength;
+                if (depth == size) {
+                    Leaf* leaf = inner->mValue;
+                    return leaf != nullptr && leaf->mPair.first == pKey ? leaf : nullptr;
+                }
+                Node** child = findChild(inner, byteAt(pKey, depth++));
+                node = child != nullptr ? *child : nullptr;
+            }
+            return nullptr;
+        }
+        //Pierwszy liść o kluczu >= pKey. Gdy całe poddrzewo jest mniejsze, wynikiem jest następnik
+        //jego największego liścia:
+        Leaf* lowerBoundLeaf(const key_type& pKey) const {
+            size_type depth = 0;
+            size_type size = keySize(pKey);
+            for (Node* node = mRoot; node != nullptr;) {
+                if (node->mType == LeafType) {
+                    Leaf* leaf = static_cast<Leaf*>(node);
+                    return leaf->mPair.first < pKey ? leaf->mNext : leaf;
+                }
+                Inner* inner = static_cast<Inner*>(node);
+                size_type mismatch = prefixMismatch(inner, pKey, depth);
+                if (mismatch < inner->mPrefixLength) {
+                    bool greater = depth + mismatch == size ||
+                                   prefixByte(inner, depth, mismatch) > byteAt(pKey, depth + mismatch);
+                    return greater ? minimumLeaf(inner) : maximumLeaf(inner)->mNext;
+                }
+                depth += inner->mPrefixLength;
+                if (depth == size)
+                    return minimumLeaf(inner);
+                unsigned char byte = byteAt(pKey, depth++);
+                Node** child = findChild(inner, byte);
+                if (child == nullptr) {
+                    Node* next = childAfter(inner, byte);
+                    return next != nullptr ? minimumLeaf(next) : maximumLeaf(inner)->mNext;
+                }
+                node = *child;
+            }
+            return nullptr;
+        }
+        //Wstawienie nowego klucza do poddrzewa w pSlot (pDepth - liczba bajtów klucza zużytych wyżej):
+        Leaf* insert(Node*& pSlot, const key_type& pKey, size_type pDepth) {
+            if (pSlot == nullptr) {//pusta mapa
+                Leaf* leaf = new Leaf(pKey);
+                pSlot = leaf;
+                linkBetween(leaf, nullptr, nullptr);
+                return leaf;
+            }
+            if (pSlot->mType == LeafType)
+                return splitLeaf(pSlot, pKey, pDepth);
+            Inner* node = static_cast<Inner*>(pSlot);
+            size_type mismatch = prefixMismatch(node, pKey, pDepth);
+            if (mismatch < node->mPrefixLength)
+                return splitPrefix(pSlot, pKey, pDepth, mismatch);
+            size_type depth = pDepth + node->mPrefixLength;
+            if (depth == keySize(pKey)) {
+                if (node->mValue != nullptr)
+                    return node->mValue;
+                Leaf* leaf = new Leaf(pKey);
+                node->mValue = leaf;
+                Leaf* next = minimumLeaf(childAfter(node, -1));//krótszy klucz jest przed kluczami dzieci
+                linkBetween(leaf, next->mPrev, next);
+                return leaf;
+            }
+            unsigned char byte = byteAt(pKey, depth);
+            Node** child = findChild(node, byte);
+            if (child != nullptr)
+                return insert(*child, pKey, depth + 1);
+            //Sąsiedzi nowego liścia: największy liść mniejszego dziecka (albo mValue) i jego następnik,
+            //a gdy w węźle nie ma nic mniejszego - najmniejszy liść większego dziecka i jego poprzednik:
+            Node* before = childBefore(node, byte);
+            Leaf* previous = before != nullptr ? maximumLeaf(before) : node->mValue;
+            Leaf* next = previous != nullptr ? previous->mNext : minimumLeaf(childAfter(node, byte));
+            if (previous == nullptr)
+                previous = next->mPrev;
+            Leaf* leaf = new Leaf(pKey);
+            try {
+                addChild(pSlot, byte, leaf);
+            } catch (...) {
+                delete leaf;
+                throw;
+            }
+            linkBetween(leaf, previous, next);
+            return leaf;
+        }
+        //Liść w miejscu nowego klucza: oba trafiają do nowego węzła 4 z ich wspólnym prefiksem:
+        Leaf* splitLeaf(Node*& pSlot, const key_type& pKey, size_type pDepth) {
+            Leaf* existing = static_cast<Leaf*>(pSlot);
+            const key_type& other = existing->mPair.first;
+            size_type size = keySize(pKey), otherSize = keySize(other);
+            size_type common = pDepth;
+            while (common < size && common < otherSize && byteAt(pKey, common) == byteAt(other, common))
+                ++common;
+            if (common == size && common == otherSize)
+                return existing;
+            Leaf* leaf = new Leaf(pKey);
+            Node4* node;
+            try {
+                node = new Node4();
+            } catch (...) {
+                delete leaf;
+                throw;
+            }
+            setPrefix(node, pKey, pDepth, common - pDepth);
+            place(node, existing, common);
+            place(node, leaf, common);
+            pSlot = node;
+            if (pKey < other)
+                linkBetween(leaf, existing->mPrev, existing);
+            else
+                linkBetween(leaf, existing, existing->mNext);
+            return leaf;
+        }
+        //Klucz rozchodzi się z prefiksem węzła na pozycji pMismatch: nowy węzeł 4 przejmuje wspólną część
+        //prefiksu, a stary węzeł i nowy liść zostają jego dziećmi:
+        Leaf* splitPrefix(Node*& pSlot, const key_type& pKey, size_type pDepth, size_type pMismatch) {
+            Inner* node = static_cast<Inner*>(pSlot);
+            Leaf* any = minimumLeaf(node);//dowolny liść poddrzewa zna pełny prefiks
+            Leaf* leaf = new Leaf(pKey);
+            Node4* parent;
+            try {
+                parent = new Node4();
+            } catch (...) {
+                delete leaf;
+                throw;
+            }
+            setPrefix(parent, pKey, pDepth, pMismatch);
+            unsigned char byte = prefixByte(node, pDepth, pMismatch);
+            setPrefix(node, any->mPair.first, pDepth + pMismatch + 1, node->mPrefixLength - pMismatch - 1);
+            insertSorted(parent, byte, node);
+            place(parent, leaf, pDepth + pMismatch);
+            pSlot = parent;
+            if (pKey < any->mPair.first)
+                linkBetween(leaf, any->mPrev, any);
+            else {
+                Leaf* last = maximumLeaf(node);
+                linkBetween(leaf, last, last->mNext);
+            }
+            return leaf;
+        }
+        //Wpis dla liścia w świeżym węźle 4 (pDepth - pozycja bajtu wybierającego dziecko):
+        static void place(Node4* pNode, Leaf* pLeaf, size_type pDepth) {
+            if (keySize(pLeaf->mPair.first) == pDepth)
+                pNode->mValue = pLeaf;
+            else
+                insertSorted(pNode, byteAt(pLeaf->mPair.first, pDepth), pLeaf);
+        }
+        //Usunięcie klucza z poddrzewa w pSlot; false, gdy go nie ma:
+        bool erase(Node*& pSlot, const key_type& pKey, size_type pDepth) {
+            if (pSlot == nullptr)
+                return false;
+            if (pSlot->mType == LeafType) {//liść w korzeniu
+                Leaf* leaf = static_cast<Leaf*>(pSlot);
+                if (!(leaf->mPair.first == pKey))
+                    return false;
+                pSlot = nullptr;
+                destroyLeaf(leaf);
+                return true;
+            }
+            Inner* node = static_cast<Inner*>(pSlot);
+            if (prefixMismatch(node, pKey, pDepth) < node->mPrefixLength)
+                return false;
+            size_type depth = pDepth + node->mPrefixLength;
+            if (depth == keySize(pKey)) {
+                Leaf* leaf = node->mValue;
+                if (leaf == nullptr)
+                    return false;
+                node->mValue = nullptr;
+                destroyLeaf(leaf);
+                if (node->mCount == 1)
+                    collapse(pSlot);
+                return true;
+            }
+            unsigned char byte = byteAt(pKey, depth);
+            Node** child = findChild(node, byte);
+            if (child == nullptr)
+                return false;
+            if ((*child)->mType != LeafType)
+                return erase(*child, pKey, depth + 1);
+            Leaf* leaf = static_cast<Leaf*>(*child);
+            if (!(leaf->mPair.first == pKey))
+                return false;
+            removeChild(pSlot, byte);
+            destroyLeaf(leaf);
+            return true;
+        }
+        //Długość zgodnej części prefiksu węzła i klucza od pozycji pDepth (mPrefixLength, gdy cały zgodny):
+        static size_type prefixMismatch(Inner* pNode, const key_type& pKey, size_type pDepth) {
+            size_type size = keySize(pKey);
+            size_type stored = std::min<size_type>(pNode->mPrefixLength, MaxPrefix);
+            for (size_type i = 0; i < stored; ++i)
+                if (pDepth + i == size || pNode->mPrefix[i] != byteAt(pKey, pDepth + i))
+                    return i;
+            if (pNode->mPrefixLength > MaxPrefix) {
+                const key_type& any = minimumLeaf(pNode)->mPair.first;
+                for (size_type i = MaxPrefix; i < pNode->mPrefixLength; ++i)
+                    if (pDepth + i == size || byteAt(any, pDepth + i) != byteAt(pKey, pDepth + i))
+                        return i;
+            }
+            return pNode->mPrefixLength;
+        }
+        //Bajt pIndex prefiksu węzła (leżącego pDepth bajtów od korzenia):
+        static unsigned char prefixByte(Inner* pNode, size_type pDepth, size_type pIndex) {
+            if (pIndex < MaxPrefix)
+                return pNode->mPrefix[pIndex];
+            return byteAt(minimumLeaf(pNode)->mPair.first, pDepth + pIndex);
+        }
+
+        static void setPrefix(Inner* pNode, const key_type& pKey, size_type pFrom, size_type pLength) {
+            pNode->mPrefixLength = static_cast<std::uint32_t>(pLength);
+            for (size_type i = 0; i < std::min(pLength, MaxPrefix); ++i)
+                pNode->mPrefix[i] = byteAt(pKey, pFrom + i);
+        }
+        //Miejsce dziecka dla bajtu pByte (nullptr, gdy brak). W węźle 16 bajty są porównywane naraz (SSE2):
+        static Node** findChild(Inner* pNode, unsigned char pByte) {
+            switch (pNode->mType) {
+                case Node4Type: {
+                    Node4* node = static_cast<Node4*>(pNode);
+                    for (int i = 0; i < node->mCount; ++i)
+                        if (node->mKeys[i] == pByte)
+                            return &node->mChildren[i];
+                    return nullptr;
+                }
+                case Node16Type: {
+                    Node16* node = static_cast<Node16*>(pNode);
+#if defined(__SSE2__)
+                    __m128i matches = _mm_cmpeq_epi8(_mm_set1_epi8(static_cast<char>(pByte)),
+                                                     _mm_loadu_si128(reinterpret_cast<const __m128i*>(node->mKeys)));
+                    unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(matches)) & ((1u << node->mCount) - 1);
+                    return mask != 0 ? &node->mChildren[__builtin_ctz(mask)] : nullptr;
+#else
+                    for (int i = 0; i < node->mCount; ++i)
+                        if (node->mKeys[i] == pByte)
+                            return &node->mChildren[i];
+                    return nullptr;
+#endif
+                }
+                case Node48Type: {
+                    Node48* node = static_cast<Node48*>(pNode);
+                    return node->mIndex[pByte] != 0 ? &node->mChildren[node->mIndex[pByte] - 1] : nullptr;
+                }
+                default: {
+                    Node256* node = static_cast<Node256*>(pNode);
+                    return node->mChildren[pByte] != nullptr ? &node->mChildren[pByte] : nullptr;
+                }
+            }
+        }
+        //Dziecko o najmniejszym bajcie > pByte (pByte = -1: pierwsze dziecko), nullptr, gdy brak:
+        static Node* childAfter(Inner* pNode, int pByte) {
+            switch (pNode->mType) {
+                case Node4Type:
+                    return sortedAfter(static_cast<Node4*>(pNode), pByte);
+                case Node16Type:
+                    return sortedAfter(static_cast<Node16*>(pNode), pByte);
+                case Node48Type: {
+                    Node48* node = static_cast<Node48*>(pNode);
+                    for (int byte = pByte + 1; byte < 256; ++byte)
+                        if (node->mIndex[byte] != 0)
+                            return node->mChildren[node->mIndex[byte] - 1];
+                    return nullptr;
+                }
+                default: {
+                    Node256* node = static_cast<Node256*>(pNode);
+                    for (int byte = pByte + 1; byte < 256; ++byte)
+                        if (node->mChildren[byte] != nullptr)
+                            return node->mChildren[byte];
+                    return nullptr;
+                }
+            }
+        }
+        //Dziecko o największym bajcie < pByte (pByte = 256: ostatnie dziecko):
+        static Node* childBefore(Inner* pNode, int pByte) {
+            switch (pNode->mType) {
+                case Node4Type:
+                    return sortedBefore(static_cast<Node4*>(pNode), pByte);
+                case Node16Type:
+                    return sortedBefore(static_cast<Node16*>(pNode), pByte);
+                case Node48Type: {
+                    Node48* node = static_cast<Node48*>(pNode);
+                    for (int byte = pByte - 1; byte >= 0; --byte)
+                        if (node->mIndex[byte] != 0)
+                            return node->mChildren[node->mIndex[byte] - 1];
+                    return nullptr;
+                }
+                default: {
+                    Node256* node = static_cast<Node256*>(pNode);
+                    for (int byte = pByte - 1; byte >= 0; --byte)
+                        if (node->mChildren[byte] != nullptr)
+                            return node->mChildren[byte];
+                    return nullptr;
+                }
+            }
+        }
+
+        template<typename Sorted>
+        static Node* sortedAfter(Sorted* pNode, int pByte) {
+            for (int i = 0; i < pNode->mCount; ++i)
+                if (pNode->mKeys[i] > pByte)
+                    return pNode->mChildren[i];
+            return nullptr;
+        }
+
+        template<typename Sorted>
+        static Node* sortedBefore(Sorted* pNode, int pByte) {
+            for (int i = pNode->mCount - 1; i >= 0; --i)
+                if (pNode->mKeys[i] < pByte)
+                    return pNode->mChildren[i];
+            return nullptr;
+        }
+        //Najmniejszy liść poddrzewa (krótszy klucz z mValue jest przed kluczami dzieci):
+        static Leaf* minimumLeaf(Node* pNode) {
+            while (pNode->mType != LeafType) {
+                Inner* inner = static_cast<Inner*>(pNode);
+                if (inner->mValue != nullptr)
+                    return inner->mValue;
+                pNode = childAfter(inner, -1);
+            }
+            return static_cast<Leaf*>(pNode);
+        }
+
+        static Leaf* maximumLeaf(Node* pNode) {
+            while (pNode->mType != LeafType) {
+                Inner* inner = static_cast<Inner*>(pNode);
+                Node* last = childBefore(inner, 256);
+                if (last == nullptr)
+                    return inner->mValue;
+                pNode = last;
+            }
+            return static_cast<Leaf*>(pNode);
+        }
+        //Dodanie dziecka dla nowego bajtu; pełny węzeł jest najpierw zamieniany na większy:
+        static void addChild(Node*& pSlot, unsigned char pByte, Node* pChild) {
+            Inner* node = static_cast<Inner*>(pSlot);
+            switch (node->mType) {
+                case Node4Type:
+                    if (node->mCount == 4)
+                        node = resize<Node16>(static_cast<Node4*>(node));
+                    break;
+                case Node16Type:
+                    if (node->mCount == 16)
+                        node = resize<Node48>(static_cast<Node16*>(node));
+                    break;
+                case Node48Type:
+                    if (node->mCount == 48)
+                        node = resize<Node256>(static_cast<Node48*>(node));
+                    break;
+                default:
+                    break;
+            }
+            pSlot = node;
+            switch (node->mType) {
+                case Node4Type:
+                    insertSorted(static_cast<Node4*>(node), pByte, pChild);
+                    break;
+                case Node16Type:
+                    insertSorted(static_cast<Node16*>(node), pByte, pChild);
+                    break;
+                case Node48Type: {
+                    Node48* node48 = static_cast<Node48*>(node);
+                    int slot = 0;
+                    while (node48->mChildren[slot] != nullptr)
+                        ++slot;
+                    node48->mChildren[slot] = pChild;
+                    node48->mIndex[pByte] = static_cast<unsigned char>(slot + 1);
+                    ++node48->mCount;
+                    break;
+                }
+                default:
+                    static_cast<Node256*>(node)->mChildren[pByte] = pChild;
+                    ++node->mCount;
+                    break;
+            }
+        }
+
+        template<typename Sorted>
+        static void insertSorted(Sorted* pNode, unsigned char pByte, Node* pChild) {
+            int position = pNode->mCount;
+            for (; position > 0 && pNode->mKeys[position - 1] > pByte; --position) {
+                pNode->mKeys[position] = pNode->mKeys[position - 1];
+                pNode->mChildren[position] = pNode->mChildren[position - 1];
+            }
+            pNode->mKeys[position] = pByte;
+            pNode->mChildren[position] = pChild;
+            ++pNode->mCount;
+        }
+        //Usunięcie dziecka dla bajtu; prawie pusty węzeł jest zamieniany na mniejszy, a węzeł z jednym
+        //wpisem - wciągany do rodzica:
+        void removeChild(Node*& pSlot, unsigned char pByte) {
+            Inner* node = static_cast<Inner*>(pSlot);
+            switch (node->mType) {
+                case Node4Type:
+                    removeSorted(static_cast<Node4*>(node), pByte);
+                    if (node->mCount + (node->mValue != nullptr ? 1 : 0) == 1)
+                        collapse(pSlot);
+                    break;
+                case Node16Type:
+                    removeSorted(static_cast<Node16*>(node), pByte);
+                    if (node->mCount == 3)
+                        pSlot = resize<Node4>(static_cast<Node16*>(node));
+                    break;
+                case Node48Type: {
+                    Node48* node48 = static_cast<Node48*>(node);
+                    node48->mChildren[node48->mIndex[pByte] - 1] = nullptr;
+                    node48->mIndex[pByte] = 0;
+                    if (--node48->mCount == 12)
+                        pSlot = resize<Node16>(node48);
+                    break;
+                }
+                default: {
+                    Node256* node256 = static_cast<Node256*>(node);
+                    node256->mChildren[pByte] = nullptr;
+                    if (--node256->mCount == 37)
+                        pSlot = resize<Node48>(node256);
+                    break;
+                }
+            }
+        }
+
+        template<typename Sorted>
+        static void removeSorted(Sorted* pNode, unsigned char pByte) {
+            int position = 0;
+            while (pNode->mKeys[position] != pByte)
+                ++position;
+            for (--pNode->mCount; position < pNode->mCount; ++position) {
+                pNode->mKeys[position] = pNode->mKeys[position + 1];
+                pNode->mChildren[position] = pNode->mChildren[position + 1];
+            }
+        }
+        //Węzeł z jednym wpisem zastępuje ten wpis; dziecko-węzeł dostaje prefiks rodzica, bajt i swój prefiks:
+        void collapse(Node*& pSlot) {
+            Node4* node = static_cast<Node4*>(pSlot);
+            if (node->mCount == 0) {
+                pSlot = node->mValue;
+            } else if (node->mChildren[0]->mType == LeafType) {
+                pSlot = node->mChildren[0];
+            } else {
+                Inner* child = static_cast<Inner*>(node->mChildren[0]);
+                unsigned char prefix[MaxPrefix];
+                size_type length = std::min<size_type>(node->mPrefixLength, MaxPrefix);
+                std::memcpy(prefix, node->mPrefix, length);
+                if (length < MaxPrefix)
+                    prefix[length++] = node->mKeys[0];
+                size_type childStored = std::min<size_type>(child->mPrefixLength, MaxPrefix);
+                for (size_type i = 0; i < childStored && length < MaxPrefix; ++i)
+                    prefix[length++] = child->mPrefix[i];
+                std::memcpy(child->mPrefix, prefix, length);
+                child->mPrefixLength += node->mPrefixLength + 1;
+                pSlot = child;
+            }
+            delete node;
+        }
+        //Kopia wpisów do węzła innego rozmiaru (stary węzeł jest usuwany):
+        template<typename Target, typename Source>
+        static Target* resize(Source* pNode) {
+            Target* target = new Target();
+            target->mPrefixLength = pNode->mPrefixLength;
+            std::memcpy(target->mPrefix, pNode->mPrefix, MaxPrefix);
+            target->mValue = pNode->mValue;
+            forEachChild(pNode, [target](unsigned char pByte, Node* pChild) {
+                Node* slot = target;//węzeł docelowy ma miejsce na wszystkie dzieci - bez zamiany
+                addChild(slot, pByte, pChild);
+            });
+            delete pNode;
+            return target;
+        }
+        //Wywołanie pFunction(bajt, dziecko) dla dzieci w kolejności bajtów:
+        template<typename Function>
+        static void forEachChild(Inner* pNode, Function pFunction) {
+            switch (pNode->mType) {
+                case Node4Type:
+                    forEachSorted(static_cast<Node4*>(pNode), pFunction);
+                    break;
+                case Node16Type:
+                    forEachSorted(static_cast<Node16*>(pNode), pFunction);
+                    break;
+                case Node48Type: {
+                    Node48* node = static_cast<Node48*>(pNode);
+                    for (int byte = 0; byte < 256; ++byte)
+                        if (node->mIndex[byte] != 0)
+                            pFunction(static_cast<unsigned char>(byte), node->mChildren[node->mIndex[byte] - 1]);
+                    break;
+                }
+                default: {
+                    Node256* node = static_cast<Node256*>(pNode);
+                    for (int byte = 0; byte < 256; ++byte)
+                        if (node->mChildren[byte] != nullptr)
+                            pFunction(static_cast<unsigned char>(byte), node->mChildren[byte]);
+                    break;
+                }
+            }
+        }
+
+        template<typename Sorted, typename Function>
+        static void forEachSorted(Sorted* pNode, Function& pFunction) {
+            for (int i = 0; i < pNode->mCount; ++i)
+                pFunction(pNode->mKeys[i], pNode->mChildren[i]);
+        }
+
+        void linkBetween(Leaf* pLeaf, Leaf* pPrevious, Leaf* pNext) {
+            pLeaf->mPrev = pPrevious;
+            pLeaf->mNext = pNext;
+            (pPrevious != nullptr ? pPrevious->mNext : mHead) = pLeaf;
+            (pNext != nullptr ? pNext->mPrev : mTail) = pLeaf;
+            ++mCount;
+        }
+
+        void destroyLeaf(Leaf* pLeaf) {
+            (pLeaf->mPrev != nullptr ? pLeaf->mPrev->mNext : mHead) = pLeaf->mNext;
+            (pLeaf->mNext != nullptr ? pLeaf->mNext->mPrev : mTail) = pLeaf->mPrev;
+            delete pLeaf;
+            --mCount;
+        }
+
+        void clear() {
+            destroyInner(mRoot);
+            for (Leaf* leaf = mHead; leaf != nullptr;) {
+                Leaf* next = leaf->mNext;
+                delete leaf;
+                leaf = next;
+            }
+            mRoot = nullptr;
+            mHead = mTail = nullptr;
+            mCount = 0;
+        }
+        //Usunięcie węzłów wewnętrznych (liście są usuwane osobno, z listy):
+        static void destroyInner(Node* pNode) {
+            if (pNode == nullptr || pNode->mType == LeafType)
+                return;
+            Inner* inner = static_cast<Inner*>(pNode);
+            forEachChild(inner, [](unsigned char, Node* pChild) { destroyInner(pChild); });
+            switch (inner->mType) {
+                case Node4Type:
+                    delete static_cast<Node4*>(inner);
+                    break;
+                case Node16Type:
+                    delete static_cast<Node16*>(inner);
+                    break;
+                case Node48Type:
+                    delete static_cast<Node48*>(inner);
+                    break;
+                default:
+                    delete static_cast<Node256*>(inner);
+                    break;
+            }
+        }
+    };
+
+    template<typename KeyType, typename ValueType, typename KeyTraits>
+    const typename RadixTreeMap<KeyType, ValueType, KeyTraits>::size_type RadixTreeMap<KeyType, ValueType, KeyTraits>::MaxPrefix;
+
+    template<typename KeyType, typename ValueType, typename KeyTraits>
+    class RadixTreeMap<KeyType, ValueType, KeyTraits>::ConstIterator {
+    public:
+        using reference = typename RadixTreeMap::const_reference;
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = typename RadixTreeMap::value_type;
+        using pointer = const typename RadixTreeMap::value_type*;
+
+        friend class RadixTreeMap;
+
+        //end() to liść nullptr:
+        explicit ConstIterator(const RadixTreeMap& pMap, Leaf* pLeaf) : mMap(&pMap), mLeaf(pLeaf) {}
+
+        ConstIterator& operator++() {
+            if (mLeaf == nullptr)
+                throw std::out_of_range("End of tree.");
+            mLeaf = mLeaf->mNext;
+            return *this;
+        }
+
+        ConstIterator operator++(int) {
+            ConstIterator temp(*this);
+            operator++();
+            return temp;
+        }
+
+        ConstIterator& operator--() {
+            Leaf* previous = mLeaf == nullptr ? mMap->mTail : mLeaf->mPrev;
+            if (previous == nullptr)
+                throw std::out_of_range("At the beginning.");
+            mLeaf = previous;
+            return *this;
+        }
+
+        ConstIterator operator--(int) {
+            ConstIterator temp(*this);
+            operator--();
+            return temp;
+        }
+
+        reference operator*() const {
+            if (mLeaf == nullptr)
+                throw std::out_of_range("Dereferencing end iterator");
+            return mLeaf->mPair;
+        }
+
+        pointer operator->() const {
+            return &this->operator*();
+        }
+
+        bool operator==(const ConstIterator& other) const {
+            return mLeaf == other.mLeaf;
+        }
+
+        bool operator!=(const ConstIterator& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        const RadixTreeMap* mMap;
+        Leaf* mLeaf; // liść z elementem (nullptr dla end)
+    };
+
+    template<typename KeyType, typename ValueType, typename KeyTraits>
+    class RadixTreeMap<KeyType, ValueType, KeyTraits>::Iterator
+            : public RadixTreeMap<KeyType, ValueType, KeyTraits>::ConstIterator {
+    public:
+        using reference = typename RadixTreeMap::reference;
+        using pointer = typename RadixTreeMap::value_type*;
+
+        explicit Iterator(const RadixTreeMap& pMap, Leaf* pLeaf) : ConstIterator(pMap, pLeaf) {}
+
+        Iterator(const ConstIterator& other)
+                : ConstIterator(other) {}
+
+        Iterator& operator++() {
+            ConstIterator::operator++();
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            auto result = *this;
+            ConstIterator::operator++();
+            return result;
+        }
+
+        Iterator& operator--() {
+            ConstIterator::operator--();
+            return *this;
+        }
+
+        Iterator operator--(int) {
+            auto result = *this;
+            ConstIterator::operator--();
+            return result;
+        }
+
+        pointer operator->() const {
+            return &this->operator*();
+        }
+
+        reference operator*() const {
+            // ugly cast, yet reduces code duplication.
+            return const_cast<reference>(ConstIterator::operator*());
+        }
+    };
+
+}
+
+#endif /* AISDI_MAPS_RADIXTREEMAP_H */
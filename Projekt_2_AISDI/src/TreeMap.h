@@ -1,17 +1,142 @@
 #ifndef AISDI_MAPS_TREEMAP_H
 #define AISDI_MAPS_TREEMAP_H
 
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
 #include <initializer_list>
+#include <limits>
+#include <mutex>
+#include <new>
 #include <stdexcept>
+#include <thread>
+#include <type_traits>
 #include <utility>
+#include <vector>
+
+#include "FrozenMap.h"
 
 namespace aisdi {
 
-    template<typename KeyType, typename ValueType>
+    //Agregat utrzymywany w węzłach TreeMap (monoid): result_type, identity() - element neutralny,
+    //lift(key, value) - wartość pojedynczego elementu, combine(a, b) - łączne (niekoniecznie przemienne),
+    //wywoływane dla kolejnych przedziałów w porządku kluczy. Wszystkie funkcje są statyczne.
+    struct NoAggregate {
+        struct result_type {};
+
+        static result_type identity() {
+            return result_type();
+        }
+
+        template<typename K, typename V>
+        static result_type lift(const K&, const V&) {
+            return result_type();
+        }
+
+        static result_type combine(const result_type&, const result_type&) {
+            return result_type();
+        }
+    };
+
+    template<typename T>
+    struct SumAggregate {
+        using result_type = T;
+
+        static result_type identity() {
+            return T();
+        }
+
+        template<typename K>
+        static result_type lift(const K&, const T& pValue) {
+            return pValue;
+        }
+
+        static result_type combine(const result_type& pLeft, const result_type& pRight) {
+            return pLeft + pRight;
+        }
+    };
+
+    template<typename T>
+    struct MaxAggregate {
+        using result_type = T;
+
+        static result_type identity() {
+            return std::numeric_limits<T>::lowest();
+        }
+
+        template<typename K>
+        static result_type lift(const K&, const T& pValue) {
+            return pValue;
+        }
+
+        static result_type combine(const result_type& pLeft, const result_type& pRight) {
+            return pLeft < pRight ? pRight : pLeft;
+        }
+    };
+
+    template<typename T>
+    struct MinAggregate {
+        using result_type = T;
+
+        static result_type identity() {
+            return std::numeric_limits<T>::max();
+        }
+
+        template<typename K>
+        static result_type lift(const K&, const T& pValue) {
+            return pValue;
+        }
+
+        static result_type combine(const result_type& pLeft, const result_type& pRight) {
+            return pRight < pLeft ? pRight : pLeft;
+        }
+    };
+
+    //Miejsce na agregat w węźle; pusty typ (NoAggregate) jest klasą bazową, więc nie zajmuje miejsca:
+    template<typename T, bool = std::is_empty<T>::value>
+    struct AggregateSlot {
+        T mAggregate;
+
+        explicit AggregateSlot(const T& pAggregate) : mAggregate(pAggregate) {}
+
+        T& aggregate() {
+            return mAggregate;
+        }
+
+        const T& aggregate() const {
+            return mAggregate;
+        }
+    };
+
+    template<typename T>
+    struct AggregateSlot<T, true> : T {
+        explicit AggregateSlot(const T&) {}
+
+        T& aggregate() {
+            return *this;
+        }
+
+        const T& aggregate() const {
+            return *this;
+        }
+    };
+
+    //Compare - ścisły porządek słaby na kluczach; gdy definiuje is_transparent, wyszukiwanie przyjmuje
+    //też klucze innych typów porównywalnych przez Compare (bez tworzenia tymczasowego key_type).
+    //Aggregate - monoid liczony dla każdego poddrzewa (np. SumAggregate<ValueType>), udostępniany przez
+    //aggregate(lo, hi) w O(log n). Zmiany wartości przez zwracane referencje (operator[], iteratory) tylko
+    //oznaczają ścieżkę do korzenia jako nieaktualną - przeliczenie następuje przy najbliższym aggregate().
+    //Przeliczenie w metodach const odbywa się pod blokadą, więc można je wołać równolegle jak inne odczyty.
+    template<typename KeyType, typename ValueType, typename Compare = std::less<KeyType>,
+             typename Aggregate = NoAggregate>
     class TreeMap {
     public:
         using key_type = KeyType;
+        using key_compare = Compare;
+        using aggregate_type = typename Aggregate::result_type;
         using mapped_type = ValueType;
         using value_type = std::pair<const key_type, mapped_type>;
         using size_type = std::size_t;
@@ -27,54 +152,97 @@ namespace aisdi {
         using iterator = Iterator;
         using const_iterator = ConstIterator;
 
-        TreeMap() : mRoot(nullptr), mCount(0) {}
+        TreeMap() : TreeMap(Compare()) {}
+
+        explicit TreeMap(const Compare& pCompare) : mRoot(nullptr), mHead(nullptr), mTail(nullptr), mCount(0),
+                                                    mCompare(pCompare) {}
 
         TreeMap(std::initializer_list<value_type> list) : TreeMap() {
             for (auto&& item : list)
                 insert(item);
         }
 
-        TreeMap(const TreeMap& other) : TreeMap() {
-            for (auto&& item : other)
-                insert(item);
+        //Kopia przez sklonowanie struktury (wysokości i rozmiary bez zmian) - O(n), bez rotacji:
+        TreeMap(const TreeMap& other) : TreeMap(other.mCompare) {
+            other.refreshShared();//kopiowane agregaty są już aktualne
+            mRoot = clone(other.mRoot, nullptr);
+            mCount = other.mCount;
         }
 
-        TreeMap(TreeMap&& other) : TreeMap() {
+        TreeMap(TreeMap&& other) : TreeMap(other.mCompare) {
             std::swap(mRoot, other.mRoot);
+            std::swap(mHead, other.mHead);
+            std::swap(mTail, other.mTail);
             std::swap(mCount, other.mCount);
+            mPool.swap(other.mPool);
         }
 
         ~TreeMap() {
-            clear(mRoot);
+            clear();
         }
 
         TreeMap& operator=(const TreeMap& other) {
-            if (*this == other)
+            if (this == &other)
                 return *this;
-            clear(mRoot);
-            for (auto&& item : other)
-                insert(item);
+            clear();
+            mCompare = other.mCompare;
+            other.refreshShared();
+            mRoot = clone(other.mRoot, nullptr);
+            mCount = other.mCount;
             return *this;
         }
 
         TreeMap& operator=(TreeMap&& other) {
-            if (*this == other)
+            if (this == &other)
                 return *this;
-            clear(mRoot);
+            clear();
             std::swap(mRoot, other.mRoot);
+            std::swap(mHead, other.mHead);
+            std::swap(mTail, other.mTail);
             std::swap(mCount, other.mCount);
+            std::swap(mCompare, other.mCompare);
+            mPool.swap(other.mPool);
             return *this;
         }
 
+        //Budowa z par o ściśle rosnących kluczach w O(n): środkowy element zostaje korzeniem,
+        //więc drzewo jest idealnie zrównoważone i nie wymaga żadnej rotacji.
+        template<typename ForwardIt>
+        static TreeMap buildFromSorted(ForwardIt first, ForwardIt last, const Compare& compare = Compare()) {
+            TreeMap map(compare);
+            size_type count = 0;
+            for (ForwardIt it = first, previous = first; it != last; previous = it, ++it, ++count)
+                if (count > 0 && !compare(previous->first, it->first))
+                    throw std::invalid_argument("Keys are not sorted.");
+            if (count > MaxSize)
+                throw std::length_error("Too many elements.");
+            map.mRoot = map.buildBalanced(first, count, nullptr);
+            return map;
+        }
+
         bool isEmpty() const {
             return mCount == 0;
         }
+        //Usunięcie wszystkich elementów w O(n) bez rekurencji: destruktory są wołane (w przejściu po liście
+        //elementów) tylko, gdy węzeł - para, agregat - ich wymaga, a pamięć węzłów wraca hurtowo z blokami puli:
+        void clear() {
+            if (!std::is_trivially_destructible<TreeNode>::value)
+                for (TreeNode* node = mHead; node != nullptr;) {
+                    TreeNode* next = node->mNext;
+                    node->~TreeNode();
+                    node = next;
+                }
+            mPool.release();
+            mRoot = mHead = mTail = nullptr;
+            mCount = 0;
+        }
 
         mapped_type& operator[](const key_type& key) {
-            TreeNode* node = findNode(key);
-            if (node != nullptr)
-                return node->mPair.second;
-            node = allocate(key);
+            TreeNode* parent;
+            TreeNode* node = descend(key, mRoot, parent);
+            if (node == nullptr)
+                node = attach(key, parent);
+            touch(node);
             return node->mPair.second;
         }
 
@@ -87,7 +255,11 @@ namespace aisdi {
         }
 
         mapped_type& valueOf(const key_type& key) {
-            return const_cast<mapped_type&>(static_cast<const TreeMap<KeyType, ValueType>*>(this)->valueOf(key));
+            TreeNode* node = findNode(key);
+            if (node == nullptr)
+                throw std::out_of_range("Key not found.");
+            touch(node);
+            return node->mPair.second;
         }
 
         const_iterator find(const key_type& key) const {
@@ -98,22 +270,345 @@ namespace aisdi {
         }
 
         iterator find(const key_type& key) {
-            return static_cast<const TreeMap<KeyType, ValueType>*>(this)->find(key);
+            return static_cast<const TreeMap*>(this)->find(key);
+        }
+        //Wyszukiwanie heterogeniczne (tylko dla przezroczystego Compare):
+        template<typename K, typename C = Compare, typename = typename C::is_transparent>
+        const_iterator find(const K& key) const {
+            return iteratorForMatch(findNode(key, mRoot));
+        }
+
+        template<typename K, typename C = Compare, typename = typename C::is_transparent>
+        iterator find(const K& key) {
+            return iteratorForMatch(findNode(key, mRoot));
+        }
+        //Wyszukiwanie palcowe: start od elementu hint, wspinaczka tylko do przodka, którego poddrzewo
+        //obejmuje key - dla kluczy bliskich hint koszt zależy od odległości, a nie od rozmiaru drzewa:
+        const_iterator find(const const_iterator& hint, const key_type& key) const {
+            return iteratorForMatch(findNode(key, fingerStart(hint.mNode, key)));
+        }
+
+        iterator find(const const_iterator& hint, const key_type& key) {
+            return static_cast<const TreeMap*>(this)->find(hint, key);
+        }
+        //Wstawienie (albo nadpisanie wartości) ze wskazówką - miejsce jest szukane od hint jak w find(hint, key).
+        //Zwracany iterator jest dobrą wskazówką dla kolejnego klucza strumienia prawie posortowanego;
+        //end() jako wskazówka oznacza klucz większy od wszystkich.
+        iterator insert(const const_iterator& hint, const key_type& key, const mapped_type& value) {
+            TreeNode* parent;
+            TreeNode* node = descend(key, fingerStart(hint.mNode != nullptr ? hint.mNode : mTail, key), parent);
+            if (node == nullptr)
+                node = attach(key, parent);
+            node->mPair.second = value;
+            touch(node);
+            return iteratorFor(node);
         }
 
         void remove(const key_type& key) {
-            removeNode(key);
+            TreeNode* node = findNode(key);
+            if (node == nullptr)
+                throw std::out_of_range("Node not found.");
+            removeNode(node);
         }
 
         void remove(const const_iterator& it) {
             if (it == end())
                 throw std::out_of_range("Removing end iterator");
-            removeNode(it.mNode->mPair.first);
+            removeNode(it.mNode);
         }
 
         size_type getSize() const {
             return mCount;
         }
+        //Pierwszy element o kluczu >= key (end, gdy brak):
+        const_iterator lowerBound(const key_type& key) const {
+            return iteratorFor(lowerBoundNode(key));
+        }
+
+        iterator lowerBound(const key_type& key) {
+            return static_cast<const TreeMap*>(this)->lowerBound(key);
+        }
+
+        template<typename K, typename C = Compare, typename = typename C::is_transparent>
+        const_iterator lowerBound(const K& key) const {
+            return iteratorFor(lowerBoundNode(key));
+        }
+
+        template<typename K, typename C = Compare, typename = typename C::is_transparent>
+        iterator lowerBound(const K& key) {
+            return iteratorFor(lowerBoundNode(key));
+        }
+        //Pierwszy element o kluczu > key (end, gdy brak):
+        const_iterator upperBound(const key_type& key) const {
+            return iteratorFor(upperBoundNode(key));
+        }
+
+        iterator upperBound(const key_type& key) {
+            return static_cast<const TreeMap*>(this)->upperBound(key);
+        }
+
+        template<typename K, typename C = Compare, typename = typename C::is_transparent>
+        const_iterator upperBound(const K& key) const {
+            return iteratorFor(upperBoundNode(key));
+        }
+
+        template<typename K, typename C = Compare, typename = typename C::is_transparent>
+        iterator upperBound(const K& key) {
+            return iteratorFor(upperBoundNode(key));
+        }
+        //Przedział elementów o kluczu równym key (pusty albo jednoelementowy):
+        std::pair<const_iterator, const_iterator> equalRange(const key_type& key) const {
+            return std::make_pair(lowerBound(key), upperBound(key));
+        }
+
+        std::pair<iterator, iterator> equalRange(const key_type& key) {
+            return std::make_pair(lowerBound(key), upperBound(key));
+        }
+
+        template<typename K, typename C = Compare, typename = typename C::is_transparent>
+        std::pair<const_iterator, const_iterator> equalRange(const K& key) const {
+            return std::make_pair(lowerBound(key), upperBound(key));
+        }
+
+        template<typename K, typename C = Compare, typename = typename C::is_transparent>
+        std::pair<iterator, iterator> equalRange(const K& key) {
+            return std::make_pair(lowerBound(key), upperBound(key));
+        }
+        //Wywołanie pFunction dla elementów o kluczach z przedziału [lo, hi) w kolejności kluczy:
+        //jedno zejście do pierwszego elementu, potem tylko następniki z listy - O(log n + k).
+        template<typename Function>
+        void forEachInRange(const key_type& lo, const key_type& hi, Function pFunction) const {
+            for (TreeNode* node = lowerBoundNode(lo); node != nullptr && mCompare(node->mPair.first, hi);
+                 node = node->mNext)
+                pFunction(static_cast<const_reference>(node->mPair));
+        }
+
+        template<typename Function>
+        void forEachInRange(const key_type& lo, const key_type& hi, Function pFunction) {
+            for (TreeNode* node = lowerBoundNode(lo); node != nullptr && mCompare(node->mPair.first, hi);
+                 node = node->mNext) {
+                touch(node);
+                pFunction(node->mPair);
+            }
+        }
+        //Liczba kluczy mniejszych od key (pozycja key w porządku, także gdy go nie ma):
+        size_type rank(const key_type& key) const {
+            return rankOf(key);
+        }
+
+        template<typename K, typename C = Compare, typename = typename C::is_transparent>
+        size_type rank(const K& key) const {
+            return rankOf(key);
+        }
+        //Element o pozycji pIndex w porządku kluczy (liczonej od 0):
+        const_iterator select(size_type pIndex) const {
+            if (pIndex >= mCount)
+                throw std::out_of_range("Index out of range.");
+            TreeNode* node = mRoot;
+            while (pIndex != sizeOf(node->mLeft))
+                if (pIndex < sizeOf(node->mLeft)) {
+                    node = node->mLeft;
+                } else {
+                    pIndex -= sizeOf(node->mLeft) + 1;
+                    node = node->mRight;
+                }
+            return iteratorFor(node);
+        }
+
+        iterator select(size_type pIndex) {
+            return static_cast<const TreeMap*>(this)->select(pIndex);
+        }
+        //Liczba kluczy z przedziału [lo, hi):
+        size_type countInRange(const key_type& lo, const key_type& hi) const {
+            return countBetween(lo, hi);
+        }
+
+        template<typename K, typename C = Compare, typename = typename C::is_transparent>
+        size_type countInRange(const K& lo, const K& hi) const {
+            return countBetween(lo, hi);
+        }
+        //Agregat elementów o kluczach z [lo, hi) w O(log n) (po przeliczeniu nieaktualnych węzłów):
+        aggregate_type aggregate(const key_type& lo, const key_type& hi) const {
+            refreshShared();
+            TreeNode* node = mRoot;
+            while (node != nullptr) {//węzeł, w którym rozchodzą się ścieżki do lo i hi
+                if (mCompare(node->mPair.first, lo))
+                    node = node->mRight;
+                else if (!mCompare(node->mPair.first, hi))
+                    node = node->mLeft;
+                else
+                    break;
+            }
+            if (node == nullptr)
+                return Aggregate::identity();
+            //Lewa ścieżka zbiera przedziały od prawej strony, prawa - od lewej (combine nie musi być przemienne):
+            aggregate_type left = Aggregate::identity();
+            for (TreeNode* it = node->mLeft; it != nullptr;) {
+                if (mCompare(it->mPair.first, lo)) {
+                    it = it->mRight;
+                } else {
+                    left = Aggregate::combine(Aggregate::combine(lift(it), aggregateOf(it->mRight)), left);
+                    it = it->mLeft;
+                }
+            }
+            aggregate_type right = Aggregate::identity();
+            for (TreeNode* it = node->mRight; it != nullptr;) {
+                if (mCompare(it->mPair.first, hi)) {
+                    right = Aggregate::combine(right, Aggregate::combine(aggregateOf(it->mLeft), lift(it)));
+                    it = it->mRight;
+                } else {
+                    it = it->mLeft;
+                }
+            }
+            return Aggregate::combine(Aggregate::combine(left, lift(node)), right);
+        }
+        //Agregat całej mapy:
+        aggregate_type aggregate() const {
+            refreshShared();
+            return aggregateOf(mRoot);
+        }
+        //Tryb drzewa przedziałów (IntervalMap): element to przedział [klucz, wartość), a agregat poddrzewa -
+        //największy koniec. Wywołanie pFunction dla przedziałów nachodzących na [lo, hi), w kolejności początków.
+        //Pomijane są poddrzewa kończące się przed lo i prawe poddrzewa węzłów zaczynających się od hi:
+        //O(log n + k) przy nakładających się przedziałach skupionych w porządku kluczy, najwyżej O(k log(n/k)).
+        template<typename Function>
+        void findOverlapping(const key_type& lo, const key_type& hi, Function pFunction) const {
+            static_assert(std::is_same<Aggregate, MaxAggregate<mapped_type>>::value,
+                          "findOverlapping requires MaxAggregate of interval ends (IntervalMap).");
+            refreshShared();
+            if (mCompare(lo, hi))
+                overlapping(mRoot, lo, hi, pFunction);
+        }
+        //Migawka tylko do odczytu w układzie Eytzingera (szybsze wyszukiwanie, gdy mapa już się nie zmienia):
+        FrozenMap<KeyType, ValueType, Compare> freeze() const {
+            return FrozenMap<KeyType, ValueType, Compare>(begin(), end(), mCompare);
+        }
+        //Podział w O(log n): w tej mapie zostają klucze < key, zwracana mapa dostaje klucze >= key.
+        TreeMap split(const key_type& key) {
+            TreeNode* less;
+            TreeNode* equal;
+            TreeNode* greater;
+            TreeNode* first = lowerBoundNode(key);//lista elementów jest przecinana przed first
+            TreeNode* last = first != nullptr ? first->mPrev : mTail;
+            splitTree(mRoot, key, less, equal, greater);
+            if (equal != nullptr)
+                greater = join(nullptr, equal, greater);
+            TreeMap result(mCompare);
+            result.mRoot = greater;
+            result.mCount = sizeOf(greater);
+            result.mPool.share(mPool);
+            if (first != nullptr) {
+                first->mPrev = nullptr;
+                result.mHead = first;
+                result.mTail = mTail;
+            }
+            if (last != nullptr)
+                last->mNext = nullptr;
+            else
+                mHead = nullptr;
+            mTail = last;
+            mRoot = less;
+            mCount = sizeOf(less);
+            return result;
+        }
+        //Usunięcie elementów o kluczach z przedziału [lo, hi) w O(k + log n): drzewo jest dzielone na części
+        //przed, w i za przedziałem, skrajne części są złączane, a węzły środkowej - niszczone po liście.
+        //Zwraca liczbę usuniętych elementów.
+        size_type eraseRange(const key_type& lo, const key_type& hi) {
+            if (!mCompare(lo, hi))
+                return 0;
+            TreeNode* first = lowerBoundNode(lo);
+            if (first == nullptr || !mCompare(first->mPair.first, hi))
+                return 0;
+            TreeNode* after = lowerBoundNode(hi);//pierwszy węzeł za przedziałem
+            TreeNode* before = first->mPrev;
+            TreeNode *less, *equal, *greater, *inRange, *rest;
+            splitTree(mRoot, lo, less, equal, greater);
+            if (equal != nullptr)
+                greater = join(nullptr, equal, greater);
+            splitTree(greater, hi, inRange, equal, rest);
+            if (equal != nullptr)
+                rest = join(nullptr, equal, rest);
+            size_type removed = 0;
+            for (TreeNode* node = first; node != after; ++removed) {
+                TreeNode* next = node->mNext;
+                destroyNode(node);
+                node = next;
+            }
+            connect(before, after);
+            if (before == nullptr)
+                mHead = after;
+            if (after == nullptr)
+                mTail = before;
+            mRoot = join2(less, rest);
+            mCount -= removed;
+            return removed;
+        }
+        //Usunięcie elementów spełniających pPredicate (wywoływany raz dla każdego elementu, w kolejności kluczy).
+        //Przy niewielu trafieniach węzły są usuwane pojedynczo (O(k log n)), przy wielu - drzewo jest budowane
+        //od nowa z pozostałych węzłów listy w O(n), bez rotacji. Zwraca liczbę usuniętych elementów.
+        template<typename Predicate>
+        size_type removeIf(Predicate pPredicate) {
+            std::vector<TreeNode*> removed;
+            for (TreeNode* node = mHead; node != nullptr; node = node->mNext)
+                if (pPredicate(static_cast<const_reference>(node->mPair)))
+                    removed.push_back(node);
+            if (removed.size() * static_cast<size_type>(getHeight(mRoot) + 1) < mCount) {
+                for (TreeNode* node : removed)
+                    removeNode(node);
+                return removed.size();
+            }
+            for (TreeNode* node : removed) {
+                unlink(node);
+                destroyNode(node);
+            }
+            mCount -= removed.size();
+            TreeNode* cursor = mHead;
+            mRoot = relink(cursor, mCount, nullptr);
+            return removed.size();
+        }
+        //Złączenie w O(log n) z mapą, której wszystkie klucze są większe albo wszystkie mniejsze od kluczy tej:
+        void join(TreeMap other) {
+            if (other.mRoot == nullptr)
+                return;
+            if (mRoot != nullptr && mCompare(mTail->mPair.first, other.mHead->mPair.first)) {
+                mRoot = join2(mRoot, other.mRoot);
+                mTail = other.mTail;
+            } else if (mRoot == nullptr || mCompare(other.mTail->mPair.first, mHead->mPair.first)) {
+                mRoot = join2(other.mRoot, mRoot);
+                mHead = other.mHead;
+                if (mTail == nullptr)
+                    mTail = other.mTail;
+            } else {
+                throw std::invalid_argument("Key ranges overlap.");
+            }
+            mCount = sizeOf(mRoot);
+            other.mRoot = other.mHead = other.mTail = nullptr;
+            other.mCount = 0;
+            mPool.adopt(other.mPool);
+        }
+        //Operacje mnogościowe na węzłach obu drzew (bez kopiowania par), O(m log(n/m + 1)) dla m <= n.
+        //Mapa other jest pobierana przez wartość - przekazana przez std::move oddaje węzły bez kopii.
+        //Dla wspólnych kluczy zostaje wartość z tej mapy. Tryb równoległy dzieli rekurencję między wątki.
+        void unionWith(TreeMap other, bool parallel = false) {
+            if (mCount + other.mCount > MaxSize)
+                throw std::length_error("Too many elements.");
+            std::vector<TreeNode*> discarded;
+            mRoot = unite(mRoot, other.mRoot, discarded, threadsFor(parallel));
+            finishSetOperation(other, discarded);
+        }
+        //Część wspólna: zostają elementy tej mapy, których klucze są w other:
+        void intersect(TreeMap other, bool parallel = false) {
+            std::vector<TreeNode*> discarded;
+            mRoot = intersection(mRoot, other.mRoot, discarded, threadsFor(parallel));
+            finishSetOperation(other, discarded);
+        }
+        //Różnica: zostają elementy tej mapy, których kluczy nie ma w other:
+        void difference(TreeMap other, bool parallel = false) {
+            std::vector<TreeNode*> discarded;
+            mRoot = subtract(mRoot, other.mRoot, discarded, threadsFor(parallel));
+            finishSetOperation(other, discarded);
+        }
 
         bool operator==(const TreeMap& other) const {
             if (mCount != other.mCount)
@@ -133,7 +628,7 @@ namespace aisdi {
         }
 
         iterator begin() {
-            return Iterator(*this, mostLeft(), false);
+            return Iterator(*this, mHead, false);
         }
 
         iterator end() {
@@ -141,7 +636,7 @@ namespace aisdi {
         }
 
         const_iterator cbegin() const {
-            return ConstIterator(*this, mostLeft(), false);
+            return ConstIterator(*this, mHead, false);
         }
 
         const_iterator cend() const {
@@ -157,170 +652,758 @@ namespace aisdi {
         }
 
     private:
+        //Pula węzłów: węzły wydzielane kolejno z coraz większych bloków (sąsiednie węzły leżą obok siebie
+        //w pamięci i nie mają narzutu malloc), zwolnione trafiają na listę wolnych. Bloki są zwalniane
+        //hurtowo w clear. Rozmiar węzła jest potrzebny dopiero w treści metod (TreeNode jest zdefiniowany niżej).
+        //Po split/join węzły jednego bloku mogą należeć do różnych map, więc blok ma licznik map,
+        //które go używają (atomowy - mapy mogą żyć w różnych wątkach) i znika razem z ostatnią z nich.
+        class NodePool {
+        public:
+            NodePool() : mFree(nullptr), mNext(nullptr), mLeft(0), mChunkSize(FirstChunkSize) {}
+
+            NodePool(const NodePool&) = delete;
+            NodePool& operator=(const NodePool&) = delete;
+
+            ~NodePool() {
+                release();
+            }
+
+            void* allocate() {
+                if (mFree != nullptr) {
+                    FreeSlot* slot = mFree;
+                    mFree = slot->mNext;
+                    return slot;
+                }
+                if (mLeft == 0)
+                    grow();
+                --mLeft;
+                return mNext++;
+            }
+
+            void deallocate(void* pNode) {
+                FreeSlot* slot = static_cast<FreeSlot*>(pNode);
+                slot->mNext = mFree;
+                mFree = slot;
+            }
+            //Zwolnienie wszystkich bloków naraz (węzły tej mapy muszą być już zniszczone):
+            void release() {
+                for (Slot* chunk : mChunks)
+                    if (--*references(chunk) == 0) {
+                        references(chunk)->~Counter();
+                        delete[] chunk;
+                    }
+                mChunks.clear();
+                mFree = nullptr;
+                mNext = nullptr;
+                mLeft = 0;
+                mChunkSize = FirstChunkSize;
+            }
+            //Współdzielenie bloków innej puli (część jej węzłów przechodzi do tej mapy); wolne miejsca
+            //tamtej puli zostają przy niej:
+            void share(const NodePool& other) {
+                mChunks.reserve(mChunks.size() + other.mChunks.size());
+                for (Slot* chunk : other.mChunks) {
+                    ++*references(chunk);
+                    mChunks.push_back(chunk);
+                }
+            }
+            //Przejęcie bloków innej puli (wszystkie jej węzły przechodzą do tej mapy). Wolne miejsca tamtej
+            //puli są porzucane - wrócą do systemu razem z blokami:
+            void adopt(NodePool& other) {
+                mChunks.insert(mChunks.end(), other.mChunks.begin(), other.mChunks.end());
+                other.mChunks.clear();
+                other.release();
+            }
+
+            void swap(NodePool& other) {
+                mChunks.swap(other.mChunks);
+                std::swap(mFree, other.mFree);
+                std::swap(mNext, other.mNext);
+                std::swap(mLeft, other.mLeft);
+                std::swap(mChunkSize, other.mChunkSize);
+            }
+
+        private:
+            using Slot = typename std::aligned_storage<sizeof(TreeNode), alignof(TreeNode)>::type;
+            using Counter = std::atomic<size_type>;
+
+            struct FreeSlot {
+                FreeSlot* mNext;
+            };
+
+            static const size_type FirstChunkSize = 16;
+            static const size_type MaxChunkSize = 4096;
+
+            std::vector<Slot*> mChunks;//używane bloki; pierwsze miejsce bloku to licznik map
+            FreeSlot* mFree;//lista zwolnionych węzłów
+            Slot* mNext;//pierwsze niewydzielone miejsce bieżącego bloku
+            size_type mLeft;//liczba niewydzielonych miejsc bieżącego bloku
+            size_type mChunkSize;
+
+            static Counter* references(Slot* pChunk) {
+                return reinterpret_cast<Counter*>(pChunk);
+            }
+
+            void grow() {
+                mChunks.reserve(mChunks.size() + 1);
+                Slot* chunk = new Slot[mChunkSize + 1];
+                new (chunk) Counter(1);
+                mChunks.push_back(chunk);
+                mNext = chunk + 1;
+                mLeft = mChunkSize;
+                if (mChunkSize < MaxChunkSize)
+                    mChunkSize *= 2;
+            }
+        };
+
+        //Rozmiar poddrzewa jest 32-bitowy (zwarty węzeł), stąd ograniczenie liczby elementów:
+        static const size_type MaxSize = 0xffffffffu;
+        //Najmniejsza łączna wielkość poddrzew, dla której opłaca się osobny wątek:
+        static const size_type ParallelGrain = 1 << 14;
+        static const bool HasAggregate = !std::is_same<Aggregate, NoAggregate>::value;
+
         TreeNode* mRoot; // wskaźnik na korzeń drzewa
+        TreeNode* mHead; // najmniejszy klucz (początek listy elementów)
+        TreeNode* mTail; // największy klucz (koniec listy elementów)
         size_type mCount; // ilość węzłów drzewa
+        NodePool mPool; // pamięć na węzły
+        Compare mCompare; // porządek kluczy
+        mutable std::mutex mRefreshMutex; // przeliczanie agregatów w metodach const
         //Wstawianie elementu do drzewa:
         TreeNode* insert(value_type pValue) {
-            TreeNode* node = allocate(pValue.first);
+            TreeNode* parent;
+            TreeNode* node = descend(pValue.first, mRoot, parent);
+            if (node == nullptr)
+                node = attach(pValue.first, parent);
             node->mPair.second = pValue.second;
+            touch(node);
             return node;
         };
-        //Funkcja odszukuje miejsce, gdzie ma być wstawiony węzeł i go wstawia po wartości klucza:
-        TreeNode* allocate(key_type pKey) {
-            TreeNode* new_node = new TreeNode(std::make_pair(pKey, ValueType()));
-            TreeNode* node = mRoot; // zaczynamy od roota
-            TreeNode* parent; //wskazanie na rodzica ( schodzimy w dół)
+        //Wstawienie nowego węzła jako dziecka pParent (miejsce wyznaczone przez descend):
+        TreeNode* attach(const key_type& pKey, TreeNode* pParent) {
+            if (mCount == MaxSize)
+                throw std::length_error("Too many elements.");
+            TreeNode* node = createNode(value_type(pKey, mapped_type()));
             ++mCount;
-            //Jeżeli drzewo jest puste:
-            if (mRoot == nullptr) {
-                mRoot = new_node;
-                return new_node;
+            node->mParent = pParent;
+            //Nowy liść sąsiaduje w porządku kluczy z rodzicem - od strony, po której został podpięty:
+            if (pParent == nullptr) {
+                mRoot = node;
+            } else if (mCompare(pKey, pParent->mPair.first)) {
+                pParent->mLeft = node;
+                node->mPrev = pParent->mPrev;
+                node->mNext = pParent;
+            } else {
+                pParent->mRight = node;
+                node->mPrev = pParent;
+                node->mNext = pParent->mNext;
+            }
+            (node->mPrev != nullptr ? node->mPrev->mNext : mHead) = node;
+            (node->mNext != nullptr ? node->mNext->mPrev : mTail) = node;
+            rebalance(pParent);
+            return node;
+        }
+
+        //Usuwanie węzła; klucze są stałe, więc węzeł z dwojgiem dzieci zastępuje następnik (przepięcie wskaźników):
+        void removeNode(TreeNode* pNode) {
+            TreeNode* retraceFrom;//najniższy węzeł, którego poddrzewo straciło element
+            unlink(pNode);
+            if (pNode->mLeft != nullptr && pNode->mRight != nullptr) {
+                TreeNode* successor = pNode->mNext;
+
+                if (successor->mParent == pNode) {
+                    retraceFrom = successor;
+                } else {
+                    retraceFrom = successor->mParent;
+                    replaceChild(successor, successor->mRight);
+                    successor->mRight = pNode->mRight;
+                    successor->mRight->mParent = successor;
+                }
+                successor->mLeft = pNode->mLeft;
+                successor->mLeft->mParent = successor;
+                successor->mHeight = pNode->mHeight;
+                replaceChild(pNode, successor);
+            } else {
+                retraceFrom = pNode->mParent;
+                replaceChild(pNode, pNode->mLeft != nullptr ? pNode->mLeft : pNode->mRight);
             }
+            destroyNode(pNode);
+            --mCount;
+            rebalance(retraceFrom);//wyrównanie drzewa
+        }
+        //Wypięcie węzła z listy elementów:
+        void unlink(TreeNode* pNode) {
+            (pNode->mPrev != nullptr ? pNode->mPrev->mNext : mHead) = pNode->mNext;
+            (pNode->mNext != nullptr ? pNode->mNext->mPrev : mTail) = pNode->mPrev;
+        }
+        //Drzewo zrównoważone z pCount kolejnych węzłów listy od pCursor (przesuwanego dalej) - jak buildBalanced,
+        //ale z istniejących węzłów:
+        TreeNode* relink(TreeNode*& pCursor, size_type pCount, TreeNode* pParent) {
+            if (pCount == 0)
+                return nullptr;
+            TreeNode* left = relink(pCursor, pCount / 2, nullptr);
+            TreeNode* node = pCursor;
+            pCursor = pCursor->mNext;
+            node->mParent = pParent;
+            node->mLeft = left;
+            if (left != nullptr)
+                left->mParent = node;
+            node->mRight = relink(pCursor, pCount - pCount / 2 - 1, node);
+            update(node);
+            return node;
+        }
+        //Podpięcie pChild (może być nullptr) w miejsce pNode u jego rodzica:
+        void replaceChild(TreeNode* pNode, TreeNode* pChild) {
+            if (pChild != nullptr)
+                pChild->mParent = pNode->mParent;
+            if (pNode->mParent == nullptr)
+                mRoot = pChild;
+            else if (pNode->mParent->mLeft == pNode)
+                pNode->mParent->mLeft = pChild;
+            else
+                pNode->mParent->mRight = pChild;
+        }
 
-            while (true) {
-                parent = node;
-                // Schodzimy w lewo (wartości klucza mniejsze od parent):
-                if (node->mPair.first > pKey) {
+        TreeNode* findNode(const key_type& pKey) const {
+            return findNode(pKey, mRoot);
+        }
+
+        //Wyszukanie z wczesnym wyjściem (oba porównania liczone bez skrótu, żeby wybór dziecka
+        //kompilował się bez skoku - zejście do liścia jak w descend wychodziło dwa razy wolniej):
+        template<typename K>
+        TreeNode* findNode(const K& pKey, TreeNode* pStart) const {
+            TreeNode* node = pStart;
+            while (node != nullptr) {
+                bool less = mCompare(pKey, node->mPair.first);
+                if (less == mCompare(node->mPair.first, pKey))
+                    return node;
+                node = less ? node->mLeft : node->mRight;
+            }
+            return nullptr;
+        }
+        //Zejście od pStart z jednym porównaniem na poziom: równe klucze idą w prawo, więc jedynym kandydatem
+        //na trafienie jest ostatni węzeł, z którego zeszliśmy w prawo (sprawdzany raz, na końcu).
+        //Zwraca węzeł z kluczem albo nullptr; pParent to rodzic miejsca, gdzie klucz należałoby wstawić:
+        template<typename K>
+        TreeNode* descend(const K& pKey, TreeNode* pStart, TreeNode*& pParent) const {
+            TreeNode* candidate = nullptr;
+            pParent = nullptr;
+            for (TreeNode* node = pStart; node != nullptr;) {
+                pParent = node;
+                if (mCompare(pKey, node->mPair.first)) {
                     node = node->mLeft;
-                    if (node == nullptr) {
-                        new_node->mParent = parent;
-                        parent->mLeft = new_node;
-                        break;
-                    }
-                } else {//schodzimy w prawo:
+                } else {
+                    candidate = node;
                     node = node->mRight;
-                    if (node == nullptr) {
-                        new_node->mParent = parent;
-                        parent->mRight = new_node;
-                        break;
-                    }
                 }
             }
-            rebalance(parent);
-            return new_node;
-        };
-
-        void removeNode(KeyType pKey) {
-            if (mRoot == nullptr)
-                throw std::out_of_range("Node not found.");
+            if (candidate != nullptr && !mCompare(candidate->mPair.first, pKey))
+                return candidate;
+            return nullptr;
+        }
 
-            TreeNode* n = mRoot;
-            TreeNode* parent = mRoot;
-            TreeNode* child = mRoot;
-            TreeNode* delNode = nullptr;
+        TreeNode* createNode(const value_type& pPair) {
+            void* memory = mPool.allocate();
+            try {
+                return new (memory) TreeNode(pPair);
+            } catch (...) {
+                mPool.deallocate(memory);
+                throw;
+            }
+        }
 
-            while (child != nullptr) {
-                parent = n;
-                n = child;
-                if (pKey >= n->mPair.first)
-                    child = n->mRight;
-                else
-                    child = n->mLeft;
+        void destroyNode(TreeNode* pNode) {
+            pNode->~TreeNode();
+            mPool.deallocate(pNode);
+        }
+        //Poddrzewo z pCount kolejnych elementów od pIt (przesuwanego dalej), budowane w porządku kluczy:
+        template<typename ForwardIt>
+        TreeNode* buildBalanced(ForwardIt& pIt, size_type pCount, TreeNode* pParent) {
+            if (pCount == 0)
+                return nullptr;
+            TreeNode* left = buildBalanced(pIt, pCount / 2, nullptr);
+            TreeNode* node = createNode(value_type(pIt->first, pIt->second));
+            ++pIt;
+            ++mCount;
+            append(node);
+            node->mParent = pParent;
+            node->mLeft = left;
+            if (left != nullptr)
+                left->mParent = node;
+            node->mRight = buildBalanced(pIt, pCount - pCount / 2 - 1, node);
+            node->mHeight = 1 + std::max(getHeight(node->mLeft), getHeight(node->mRight));
+            updateSummary(node);
+            return node;
+        }
+        //Dopisanie węzła na koniec listy elementów (budowa mapy w porządku kluczy):
+        void append(TreeNode* pNode) {
+            pNode->mPrev = mTail;
+            (mTail != nullptr ? mTail->mNext : mHead) = pNode;
+            mTail = pNode;
+        }
+        //Odłączenie dzieci węzła (węzeł zostaje liściem, dzieci - korzeniami bez rodzica):
+        static void detachChildren(TreeNode* pNode, TreeNode*& pLeft, TreeNode*& pRight) {
+            pLeft = pNode->mLeft;
+            pRight = pNode->mRight;
+            if (pLeft != nullptr)
+                pLeft->mParent = nullptr;
+            if (pRight != nullptr)
+                pRight->mParent = nullptr;
+            pNode->mLeft = pNode->mRight = nullptr;
+            update(pNode);
+        }
 
-                if (pKey == n->mPair.first)
-                    delNode = n;
-            }
-            //Jeżeli nie znaleziono:
-            if (!delNode)
-                throw std::out_of_range("Node not found.");
-            //Znaleziony:
-            if (n->mLeft)
-                child = n->mLeft;
+        static TreeNode* link(TreeNode* pLeft, TreeNode* pNode, TreeNode* pRight) {
+            pNode->mLeft = pLeft;
+            pNode->mRight = pRight;
+            pNode->mParent = nullptr;
+            if (pLeft != nullptr)
+                pLeft->mParent = pNode;
+            if (pRight != nullptr)
+                pRight->mParent = pNode;
+            update(pNode);
+            return pNode;
+        }
+        //Złączenie drzew pLeft < pNode < pRight (pNode - pojedynczy węzeł) w O(|h(pLeft) - h(pRight)|):
+        //niższe drzewo jest doczepiane na brzegu wyższego na poziomie o podobnej wysokości, a rotacje
+        //w drodze powrotnej przywracają zrównoważenie. Wynik jest korzeniem bez rodzica.
+        static TreeNode* join(TreeNode* pLeft, TreeNode* pNode, TreeNode* pRight) {
+            TreeNode* root;
+            if (getHeight(pLeft) > getHeight(pRight) + 1)
+                root = joinRight(pLeft, pNode, pRight);
+            else if (getHeight(pRight) > getHeight(pLeft) + 1)
+                root = joinLeft(pLeft, pNode, pRight);
             else
-                child = n->mRight;
-            //Jeżeli do usunięcia root:
-            if (mRoot->mPair.first == pKey) {
-                mRoot = child;
+                root = link(pLeft, pNode, pRight);
+            root->mParent = nullptr;
+            return root;
+        }
+        //pLeft wyższe - zejście jego prawym brzegiem:
+        static TreeNode* joinRight(TreeNode* pLeft, TreeNode* pNode, TreeNode* pRight) {
+            TreeNode* child = pLeft->mRight;
+            TreeNode* joined = getHeight(child) <= getHeight(pRight) + 1 ? link(child, pNode, pRight)
+                                                                          : joinRight(child, pNode, pRight);
+            pLeft->mRight = joined;
+            joined->mParent = pLeft;
+            return balance(pLeft);
+        }
+        //pRight wyższe - zejście jego lewym brzegiem:
+        static TreeNode* joinLeft(TreeNode* pLeft, TreeNode* pNode, TreeNode* pRight) {
+            TreeNode* child = pRight->mLeft;
+            TreeNode* joined = getHeight(child) <= getHeight(pLeft) + 1 ? link(pLeft, pNode, child)
+                                                                         : joinLeft(pLeft, pNode, child);
+            pRight->mLeft = joined;
+            joined->mParent = pRight;
+            return balance(pRight);
+        }
+        //Złączenie bez węzła środkowego - zostaje nim największy węzeł pLeft. Drzewa mogą pochodzić z różnych
+        //miejsc listy elementów, więc jest ona zszywana na styku:
+        static TreeNode* join2(TreeNode* pLeft, TreeNode* pRight) {
+            if (pLeft == nullptr)
+                return pRight;
+            if (pRight == nullptr)
+                return pLeft;
+            TreeNode* last;
+            TreeNode* rest = splitLast(pLeft, last);
+            connect(last, leftmost(pRight));
+            return join(rest, last, pRight);
+        }
+        //Złączenie jak join, ze zszyciem listy elementów po obu stronach pNode (O(wysokość) na znalezienie
+        //skrajnych węzłów - dla operacji mnogościowych, które składają drzewa z kawałków obu map):
+        static TreeNode* joinLinked(TreeNode* pLeft, TreeNode* pNode, TreeNode* pRight) {
+            connect(rightmost(pLeft), pNode);
+            connect(pNode, leftmost(pRight));
+            return join(pLeft, pNode, pRight);
+        }
+        //pFirst bezpośrednio przed pSecond w liście elementów (każdy z nich może być nullptr):
+        static void connect(TreeNode* pFirst, TreeNode* pSecond) {
+            if (pFirst != nullptr)
+                pFirst->mNext = pSecond;
+            if (pSecond != nullptr)
+                pSecond->mPrev = pFirst;
+        }
+        //Odcięcie największego węzła (pLast) od drzewa, zwraca korzeń reszty:
+        static TreeNode* splitLast(TreeNode* pRoot, TreeNode*& pLast) {
+            TreeNode* left;
+            TreeNode* right;
+            detachChildren(pRoot, left, right);
+            if (right == nullptr) {
+                pLast = pRoot;
+                return left;
+            }
+            TreeNode* rest = splitLast(right, pLast);
+            return join(left, pRoot, rest);
+        }
+        //Podział drzewa na klucze < pKey, węzeł z pKey (albo nullptr) i klucze > pKey, O(log n):
+        void splitTree(TreeNode* pRoot, const key_type& pKey, TreeNode*& pLess, TreeNode*& pEqual,
+                              TreeNode*& pGreater) {
+            if (pRoot == nullptr) {
+                pLess = pEqual = pGreater = nullptr;
+                return;
+            }
+            TreeNode* left;
+            TreeNode* right;
+            detachChildren(pRoot, left, right);
+            if (mCompare(pKey, pRoot->mPair.first)) {
+                TreeNode* greater;
+                splitTree(left, pKey, pLess, pEqual, greater);
+                pGreater = join(greater, pRoot, right);
+            } else if (mCompare(pRoot->mPair.first, pKey)) {
+                TreeNode* less;
+                splitTree(right, pKey, less, pEqual, pGreater);
+                pLess = join(left, pRoot, less);
             } else {
-                if (parent->mLeft == n)
-                    parent->mLeft = child;
-                else
-                    parent->mRight = child;
-                rebalance(parent);//wyrównanie drzewa
+                pLess = left;
+                pEqual = pRoot;
+                pGreater = right;
             }
-            delete n;
-            --mCount;
         }
-
-
-        TreeNode* findNode(const key_type& pKey) const {
-            TreeNode* root = mRoot;
-            while (root != nullptr && root->mPair.first != pKey)
-                if (root->mPair.first < pKey)
-                    root = root->mRight;
-                else
-                    root = root->mLeft;
-            return root;
+        //Liczba wątków dla operacji mnogościowej:
+        static int threadsFor(bool pParallel) {
+            return pParallel ? std::max(1u, std::thread::hardware_concurrency()) : 1;
+        }
+        //Wywołanie pFirst i pSecond (niezależnych - działają na rozłącznych poddrzewach); przy dużych
+        //poddrzewach i wolnych wątkach pSecond idzie do osobnego wątku z własną listą odrzuconych węzłów:
+        template<typename First, typename Second>
+        static void inParallel(int pThreads, size_type pWork, std::vector<TreeNode*>& pDiscarded,
+                               First pFirst, Second pSecond) {
+            if (pThreads < 2 || pWork < ParallelGrain) {
+                pFirst(pDiscarded, pThreads);
+                pSecond(pDiscarded, pThreads);
+                return;
+            }
+            std::vector<TreeNode*> discarded;
+            auto task = std::async(std::launch::async, [&]() { pSecond(discarded, pThreads / 2); });
+            pFirst(pDiscarded, pThreads - pThreads / 2);
+            task.get();
+            pDiscarded.insert(pDiscarded.end(), discarded.begin(), discarded.end());
+        }
+        //Suma: korzeń pFirst dzieli pSecond, połówki są łączone rekurencyjnie:
+        TreeNode* unite(TreeNode* pFirst, TreeNode* pSecond, std::vector<TreeNode*>& pDiscarded, int pThreads) {
+            if (pFirst == nullptr)
+                return pSecond;
+            if (pSecond == nullptr)
+                return pFirst;
+            TreeNode *left, *right, *less, *equal, *greater;
+            size_type work = sizeOf(pFirst) + sizeOf(pSecond);
+            detachChildren(pFirst, left, right);
+            splitTree(pSecond, pFirst->mPair.first, less, equal, greater);
+            if (equal != nullptr)
+                pDiscarded.push_back(equal);
+            inParallel(pThreads, work, pDiscarded,
+                       [&](std::vector<TreeNode*>& pOut, int pCount) { left = unite(left, less, pOut, pCount); },
+                       [&](std::vector<TreeNode*>& pOut, int pCount) { right = unite(right, greater, pOut, pCount); });
+            return joinLinked(left, pFirst, right);
         }
 
-        void clear(TreeNode* pRoot) {
+        TreeNode* intersection(TreeNode* pFirst, TreeNode* pSecond, std::vector<TreeNode*>& pDiscarded,
+                                      int pThreads) {
+            if (pFirst == nullptr || pSecond == nullptr) {
+                if (pFirst != nullptr)
+                    pDiscarded.push_back(pFirst);
+                if (pSecond != nullptr)
+                    pDiscarded.push_back(pSecond);
+                return nullptr;
+            }
+            TreeNode *left, *right, *less, *equal, *greater;
+            size_type work = sizeOf(pFirst) + sizeOf(pSecond);
+            detachChildren(pFirst, left, right);
+            splitTree(pSecond, pFirst->mPair.first, less, equal, greater);
+            inParallel(pThreads, work, pDiscarded,
+                       [&](std::vector<TreeNode*>& pOut, int pCount) { left = intersection(left, less, pOut, pCount); },
+                       [&](std::vector<TreeNode*>& pOut, int pCount) {
+                           right = intersection(right, greater, pOut, pCount);
+                       });
+            if (equal != nullptr) {
+                pDiscarded.push_back(equal);
+                return joinLinked(left, pFirst, right);
+            }
+            pDiscarded.push_back(pFirst);
+            return join2(left, right);
+        }
+        //Różnica: korzeń pSecond dzieli pFirst, sam pSecond i jego odpowiednik w pFirst są odrzucane:
+        TreeNode* subtract(TreeNode* pFirst, TreeNode* pSecond, std::vector<TreeNode*>& pDiscarded,
+                                  int pThreads) {
+            if (pFirst == nullptr || pSecond == nullptr) {
+                if (pSecond != nullptr)
+                    pDiscarded.push_back(pSecond);
+                return pFirst;
+            }
+            TreeNode *left, *right, *less, *equal, *greater;
+            size_type work = sizeOf(pFirst) + sizeOf(pSecond);
+            detachChildren(pSecond, left, right);
+            splitTree(pFirst, pSecond->mPair.first, less, equal, greater);
+            pDiscarded.push_back(pSecond);
+            if (equal != nullptr)
+                pDiscarded.push_back(equal);
+            inParallel(pThreads, work, pDiscarded,
+                       [&](std::vector<TreeNode*>& pOut, int pCount) { less = subtract(less, left, pOut, pCount); },
+                       [&](std::vector<TreeNode*>& pOut, int pCount) {
+                           greater = subtract(greater, right, pOut, pCount);
+                       });
+            return join2(less, greater);
+        }
+        //Węzły other należą teraz do tej mapy (razem z blokami puli), odrzucone poddrzewa są niszczone:
+        void finishSetOperation(TreeMap& pOther, const std::vector<TreeNode*>& pDiscarded) {
+            if (mRoot != nullptr)
+                mRoot->mParent = nullptr;
+            mCount = sizeOf(mRoot);
+            mHead = leftmost(mRoot);
+            mTail = rightmost(mRoot);
+            connect(nullptr, mHead);
+            connect(mTail, nullptr);
+            pOther.mRoot = pOther.mHead = pOther.mTail = nullptr;
+            pOther.mCount = 0;
+            mPool.adopt(pOther.mPool);
+            for (TreeNode* root : pDiscarded)
+                destroyTree(root);
+        }
 
+        void destroyTree(TreeNode* pRoot) {
             if (pRoot == nullptr)
                 return;
-            //Rekurencyjne wywołanie (przejście po całym drzewie):
-            clear(pRoot->mLeft);
-            clear(pRoot->mRight);
-
-            if (pRoot->mLeft != nullptr) {
-                --mCount;
-                delete pRoot->mLeft;
-                pRoot->mLeft = nullptr;
-            }
-            if (pRoot->mRight != nullptr) {
-                --mCount;
-                delete pRoot->mRight;
-                pRoot->mRight = nullptr;
-            }
-            if (pRoot == mRoot) {
-                delete mRoot;
-                mRoot = nullptr;
-                --mCount;
-            }
-        }
-        //Zwracanie node'a z najmniejszym kluczem:
-        TreeNode* mostLeft() const {
-            TreeNode* temp = mRoot;
-            if (temp == nullptr)
-                return nullptr;
-            while (temp->mLeft != nullptr)
-                temp = temp->mLeft;
-            return temp;
+            destroyTree(pRoot->mLeft);
+            destroyTree(pRoot->mRight);
+            destroyNode(pRoot);
         }
-        //Największy klucz:
-        TreeNode* mostRight() const {
-            TreeNode* temp = mRoot;
-            if (temp == nullptr)
+        //Kopia poddrzewa razem z wysokościami i rozmiarami. Węzły są tworzone w porządku kluczy, więc kolejne
+        //elementy listy leżą obok siebie w blokach puli (przejście po kopii czyta pamięć sekwencyjnie):
+        TreeNode* clone(const TreeNode* pNode, TreeNode* pParent) {
+            if (pNode == nullptr)
                 return nullptr;
+            TreeNode* left = clone(pNode->mLeft, nullptr);
+            TreeNode* node = createNode(pNode->mPair);
+            node->mParent = pParent;
+            node->mHeight = pNode->mHeight;
+            node->mSize = pNode->mSize;
+            node->mDirty.store(false, std::memory_order_relaxed);//oryginał przeliczony przed kopiowaniem
+            node->aggregate() = pNode->aggregate();
+            node->mLeft = left;
+            if (left != nullptr)
+                left->mParent = node;
+            append(node);
+            node->mRight = clone(pNode->mRight, node);
+            return node;
+        }
+        //Najniżej położony węzeł o kluczu >= pKey (w zejściu zapamiętujemy ostatni taki węzeł):
+        template<typename K>
+        TreeNode* lowerBoundNode(const K& pKey) const {
+            TreeNode* result = nullptr;
+            for (TreeNode* node = mRoot; node != nullptr;)
+                if (mCompare(node->mPair.first, pKey)) {
+                    node = node->mRight;
+                } else {
+                    result = node;
+                    node = node->mLeft;
+                }
+            return result;
+        }
+        //To samo dla klucza > pKey:
+        template<typename K>
+        TreeNode* upperBoundNode(const K& pKey) const {
+            TreeNode* result = nullptr;
+            for (TreeNode* node = mRoot; node != nullptr;)
+                if (mCompare(pKey, node->mPair.first)) {
+                    result = node;
+                    node = node->mLeft;
+                } else {
+                    node = node->mRight;
+                }
+            return result;
+        }
 
-            while (temp->mRight)
-                temp = temp->mRight;
-            return temp;
+        //Najniższy przodek pHint (lub on sam), w którego poddrzewie musi leżeć pKey. Dla pKey większego od
+        //klucza węzła ograniczeniem poddrzewa z góry jest pierwszy przodek, do którego dochodzi się od lewego
+        //dziecka - jeżeli pKey jest od niego mniejszy, węzeł wystarcza; inaczej szukamy dalej od tego przodka.
+        //Najpierw sprawdzenie w O(1) po liście: klucz między pHint a jego sąsiadem należy pod ten z nich,
+        //który nie ma dziecka od strony drugiego (strumień prawie posortowany nie wspina się wcale).
+        TreeNode* fingerStart(TreeNode* pHint, const key_type& pKey) const {
+            if (pHint == nullptr)
+                return mRoot;
+            if (mCompare(pHint->mPair.first, pKey)) {
+                TreeNode* next = pHint->mNext;
+                if (next == nullptr || mCompare(pKey, next->mPair.first))
+                    return pHint->mRight == nullptr ? pHint : next;
+                if (!mCompare(next->mPair.first, pKey))
+                    return next;
+            } else if (mCompare(pKey, pHint->mPair.first)) {
+                TreeNode* previous = pHint->mPrev;
+                if (previous == nullptr || mCompare(previous->mPair.first, pKey))
+                    return pHint->mLeft == nullptr ? pHint : previous;
+                if (!mCompare(pKey, previous->mPair.first))
+                    return previous;
+            } else {
+                return pHint;
+            }
+            TreeNode* node = pHint;
+            while (mCompare(node->mPair.first, pKey)) {
+                TreeNode* child = node;
+                while (child->mParent != nullptr && child->mParent->mRight == child)
+                    child = child->mParent;
+                if (child->mParent == nullptr || mCompare(pKey, child->mParent->mPair.first))
+                    return node;
+                node = child->mParent;
+            }
+            while (mCompare(pKey, node->mPair.first)) {
+                TreeNode* child = node;
+                while (child->mParent != nullptr && child->mParent->mLeft == child)
+                    child = child->mParent;
+                if (child->mParent == nullptr || mCompare(child->mParent->mPair.first, pKey))
+                    return node;
+                node = child->mParent;
+            }
+            return node;
+        }
+
+        template<typename K>
+        size_type rankOf(const K& pKey) const {
+            size_type result = 0;
+            for (TreeNode* node = mRoot; node != nullptr;)
+                if (mCompare(node->mPair.first, pKey)) {
+                    result += sizeOf(node->mLeft) + 1;
+                    node = node->mRight;
+                } else {
+                    node = node->mLeft;
+                }
+            return result;
+        }
+        //Przedział pusty, gdy lo >= hi (bez porównywania lo z hi - dla kluczy heterogenicznych Compare może go nie mieć):
+        template<typename K>
+        size_type countBetween(const K& pLo, const K& pHi) const {
+            size_type lo = rankOf(pLo), hi = rankOf(pHi);
+            return hi > lo ? hi - lo : 0;
         }
-        //Funkcja wyrównująca drzewo:
-        void rebalance(TreeNode* pRoot) {
 
-            pRoot->mHeight = 1 + std::max(getHeight(pRoot->mLeft), getHeight(pRoot->mRight));
+        const_iterator iteratorForMatch(TreeNode* pNode) const {
+            return pNode == nullptr ? end() : iteratorFor(pNode);
+        }
+
+        const_iterator iteratorFor(TreeNode* pNode) const {
+            return ConstIterator(*this, pNode, pNode == nullptr);
+        }
+        //Węzeł z najmniejszym kluczem poddrzewa (nullptr dla pustego):
+        static TreeNode* leftmost(TreeNode* pRoot) {
+            if (pRoot != nullptr)
+                while (pRoot->mLeft != nullptr)
+                    pRoot = pRoot->mLeft;
+            return pRoot;
+        }
+        //Największy klucz poddrzewa:
+        static TreeNode* rightmost(TreeNode* pRoot) {
+            if (pRoot != nullptr)
+                while (pRoot->mRight != nullptr)
+                    pRoot = pRoot->mRight;
+            return pRoot;
+        }
+        //Wyrównanie drzewa po wstawieniu/usunięciu: wędrówka w górę od pNode (iteracyjnie),
+        //kończona, gdy wysokość poddrzewa się nie zmieniła - wyżej nic się nie zmienia:
+        //Rozmiary (i agregaty) poddrzew zmieniają się jednak aż do korzenia, więc dalej są tylko przeliczane:
+        void rebalance(TreeNode* pNode) {
+            while (pNode != nullptr) {
+                int oldHeight = pNode->mHeight;
+                pNode = balance(pNode);
+                if (pNode->mParent == nullptr)
+                    mRoot = pNode;
+                bool unchanged = pNode->mHeight == oldHeight;
+                pNode = pNode->mParent;
+                if (unchanged)
+                    break;
+            }
+            for (; pNode != nullptr; pNode = pNode->mParent)
+                updateSummary(pNode);
+        }
+        //Aktualizacja wysokości i ewentualna rotacja w jednym węźle, zwraca nowy korzeń poddrzewa:
+        //(nie dotyka pól mapy, więc działa też na odłączonych poddrzewach, np. w osobnych wątkach):
+        static TreeNode* balance(TreeNode* pRoot) {
+            update(pRoot);
 
             int balance = getHeight(pRoot->mRight) - getHeight(pRoot->mLeft);
             //Gdy wysokość większa po stronie lewej:
             if (balance == -2) {
                 if (getHeight(pRoot->mLeft->mRight) - getHeight(pRoot->mLeft->mLeft) > 0)
-                    pRoot->mLeft = rotateLeft(pRoot->mLeft);
-                rotateRight(pRoot);
+                    rotateLeft(pRoot->mLeft);
+                pRoot = rotateRight(pRoot);
             //Po stronie prawej
             } else if (balance == 2) {
                 if (getHeight(pRoot->mRight->mRight) - getHeight(pRoot->mRight->mLeft) < 0)
-                    pRoot->mRight = rotateRight(pRoot->mRight);
-                rotateLeft(pRoot);
+                    rotateRight(pRoot->mRight);
+                pRoot = rotateLeft(pRoot);
             }
+            return pRoot;
+        }
+        //Wysokość, rozmiar i agregat węzła na podstawie dzieci:
+        static void update(TreeNode* pNode) {
+            pNode->mHeight = 1 + std::max(getHeight(pNode->mLeft), getHeight(pNode->mRight));
+            updateSummary(pNode);
+        }
+        //Rozmiar i agregat węzła na podstawie dzieci. Nieaktualne dziecko czyni nieaktualnym węzeł
+        //(przeliczy go refresh), aktualne - pozwala przeliczyć agregat od razu:
+        static void updateSummary(TreeNode* pNode) {
+            pNode->mSize = static_cast<std::uint32_t>(1 + sizeOf(pNode->mLeft) + sizeOf(pNode->mRight));
+            if (!HasAggregate)
+                return;
+            if (isDirty(pNode->mLeft) || isDirty(pNode->mRight))
+                pNode->mDirty.store(true, std::memory_order_relaxed);
+            else if (!isDirty(pNode))
+                recompute(pNode);
+        }
 
-            if (pRoot->mParent != nullptr)
-                rebalance(pRoot->mParent);
-            else
-                mRoot = pRoot;
+        static void recompute(TreeNode* pNode) {
+            pNode->aggregate() = Aggregate::combine(Aggregate::combine(aggregateOf(pNode->mLeft), lift(pNode)),
+                                                    aggregateOf(pNode->mRight));
+        }
+
+        template<typename Function>
+        void overlapping(const TreeNode* pNode, const key_type& pLo, const key_type& pHi, Function& pFunction) const {
+            if (pNode == nullptr || !mCompare(pLo, pNode->aggregate()))
+                return;
+            overlapping(pNode->mLeft, pLo, pHi, pFunction);
+            if (!mCompare(pNode->mPair.first, pHi))
+                return;
+            if (mCompare(pLo, pNode->mPair.second))
+                pFunction(static_cast<const_reference>(pNode->mPair));
+            overlapping(pNode->mRight, pLo, pHi, pFunction);
+        }
+
+        static aggregate_type lift(const TreeNode* pNode) {
+            return Aggregate::lift(pNode->mPair.first, pNode->mPair.second);
+        }
+
+        static bool isDirty(const TreeNode* pNode) {
+            return pNode != nullptr && pNode->mDirty.load(std::memory_order_relaxed);
+        }
+
+        static aggregate_type aggregateOf(const TreeNode* pNode) {
+            return pNode == nullptr ? Aggregate::identity() : pNode->aggregate();
+        }
+        //Wartość węzła mogła się zmienić (oddana referencja) - oznaczenie ścieżki do korzenia,
+        //do pierwszego już oznaczonego przodka:
+        static void touch(TreeNode* pNode) {
+            if (!HasAggregate)
+                return;
+            for (; pNode != nullptr && !isDirty(pNode); pNode = pNode->mParent)
+                pNode->mDirty.store(true, std::memory_order_relaxed);
+        }
+        //Przeliczenie przed odczytem agregatów w metodzie const. Aktualny korzeń oznacza aktualne całe drzewo;
+        //jego flaga jest zerowana na końcu przeliczenia (release), więc odczyt, który ją widzi (acquire),
+        //widzi też przeliczone agregaty. Nieaktualne drzewo przelicza jeden wątek naraz:
+        void refreshShared() const {
+            if (mRoot == nullptr || !mRoot->mDirty.load(std::memory_order_acquire))
+                return;
+            std::lock_guard<std::mutex> guard(mRefreshMutex);
+            refresh(mRoot);
+        }
+        //Przeliczenie nieaktualnych agregatów (tylko oznaczone poddrzewa):
+        static void refresh(TreeNode* pNode) {
+            if (!isDirty(pNode))
+                return;
+            refresh(pNode->mLeft);
+            refresh(pNode->mRight);
+            recompute(pNode);
+            pNode->mDirty.store(false, std::memory_order_release);
         }
         //Obrót w lewo
-        TreeNode* rotateLeft(TreeNode* pRoot) {
+        static TreeNode* rotateLeft(TreeNode* pRoot) {
             TreeNode* temp = pRoot->mRight;
             temp->mParent = pRoot->mParent;
             pRoot->mRight = temp->mLeft;
@@ -339,12 +1422,14 @@ namespace aisdi {
             }
             pRoot->mHeight = std::max(getHeight(pRoot->mLeft), getHeight(pRoot->mRight)) + 1;
             temp->mHeight = std::max(getHeight(temp->mLeft), getHeight(temp->mRight)) + 1;
+            updateSummary(pRoot);
+            updateSummary(temp);
 
             return temp;
         }
 
         //Obrót w prawo:
-        TreeNode* rotateRight(TreeNode* pRoot) {
+        static TreeNode* rotateRight(TreeNode* pRoot) {
             TreeNode* temp = pRoot->mLeft;
             temp->mParent = pRoot->mParent;
             pRoot->mLeft = temp->mRight;
@@ -363,33 +1448,46 @@ namespace aisdi {
             }
             pRoot->mHeight = std::max(getHeight(pRoot->mLeft), getHeight(pRoot->mRight)) + 1;
             temp->mHeight = std::max(getHeight(temp->mLeft), getHeight(temp->mRight)) + 1;
+            updateSummary(pRoot);
+            updateSummary(temp);
 
             return temp;
         }
 
-        inline int getHeight(const TreeNode* pRoot) const {
+        static int getHeight(const TreeNode* pRoot) {
             if (pRoot == nullptr)
                 return -1;
             return pRoot->mHeight;
         }
+        //Liczba węzłów poddrzewa:
+        static size_type sizeOf(const TreeNode* pRoot) {
+            return pRoot == nullptr ? 0 : pRoot->mSize;
+        }
     };
-    //Węzeł drzewa:
-    template<typename KeyType, typename ValueType>
-    struct TreeMap<KeyType, ValueType>::TreeNode {
+    //Węzeł drzewa. Lista następników, rozmiar i agregat kosztują miejsce (dla <int, int> 56 B), a wskaźników
+    //nie da się zastąpić indeksami - split/join przekazują węzły między mapami. Dla dużych map małych
+    //elementów bez tych operacji jest CompactTreeMap (indeksy 32-bitowe, 20 B na węzeł):
+    template<typename KeyType, typename ValueType, typename Compare, typename Aggregate>
+    struct TreeMap<KeyType, ValueType, Compare, Aggregate>::TreeNode : AggregateSlot<aggregate_type> {
         value_type mPair;//para klucz porządkujący/wartość
         TreeNode* mParent;//wskaźnik na rodzica (dla root nullptr)
         TreeNode* mLeft;//wskaźnik na lewego potomka
         TreeNode* mRight;//wskaźnik na prawego potomka
-        int mHeight;//wysokość węzła
+        TreeNode* mPrev;//poprzednik w porządku kluczy (lista elementów do iteracji)
+        TreeNode* mNext;//następnik w porządku kluczy
+        std::uint32_t mSize;//liczba węzłów poddrzewa (do rank/select)
+        std::int8_t mHeight;//wysokość węzła (AVL o 2^32 węzłach ma wysokość < 50)
+        std::atomic<bool> mDirty;//agregat poddrzewa nieaktualny (wtedy nieaktualni są też wszyscy przodkowie)
 
-        TreeNode() : mPair(std::make_pair(KeyType(), ValueType())), mParent(nullptr), mLeft(nullptr), mRight(nullptr),
-                     mHeight(0) {}
+        TreeNode() : TreeNode(std::make_pair(KeyType(), ValueType())) {}
 
-        TreeNode(value_type pPair) : mPair(pPair), mParent(nullptr), mLeft(nullptr), mRight(nullptr), mHeight(0) {}
+        TreeNode(value_type pPair) : AggregateSlot<aggregate_type>(Aggregate::lift(pPair.first, pPair.second)),
+                                     mPair(pPair), mParent(nullptr), mLeft(nullptr), mRight(nullptr), mPrev(nullptr),
+                                     mNext(nullptr), mSize(1), mHeight(0), mDirty(false) {}
     };
 
-    template<typename KeyType, typename ValueType>
-    class TreeMap<KeyType, ValueType>::ConstIterator {
+    template<typename KeyType, typename ValueType, typename Compare, typename Aggregate>
+    class TreeMap<KeyType, ValueType, Compare, Aggregate>::ConstIterator {
     public:
         using reference = typename TreeMap::const_reference;
         using iterator_category = std::bidirectional_iterator_tag;
@@ -398,25 +1496,15 @@ namespace aisdi {
 
         friend class TreeMap;
 
-        explicit ConstIterator(const TreeMap& pMap, TreeNode* pNode, bool pEnd) : mMap(pMap), mNode(pNode),
+        explicit ConstIterator(const TreeMap& pMap, TreeNode* pNode, bool pEnd) : mMap(&pMap), mNode(pNode),
                                                                                   mEnd(pEnd) {}
 
-        ConstIterator(const ConstIterator& other) : ConstIterator(other.mMap, other.mNode, other.mEnd) {}
-
         ConstIterator& operator++() {
             if (mNode == nullptr)
                 throw std::out_of_range("End of tree.");
-            //Jeżeli istnieje prawy potomek, to w prawo i do końca w lewo:
-            if (mNode->mRight != nullptr) {
-                mNode = mNode->mRight;
-                while (mNode->mLeft) mNode = mNode->mLeft;
-            } else {//jeżeli nie to do parenta:
-                while (mNode->mParent != nullptr && mNode->mParent->mRight == mNode)
-                    mNode = mNode->mParent;
-                mNode = mNode->mParent;
-                if (mNode == nullptr)
-                    mEnd = true;
-            }
+            mNode = mNode->mNext;
+            if (mNode == nullptr)
+                mEnd = true;
             return *this;
         }
 
@@ -431,17 +1519,11 @@ namespace aisdi {
                 if (!mEnd) {
                     throw std::out_of_range("At the beginning.");
                 } else {
-                    mNode = mMap.mostRight();
+                    mNode = mMap->mTail;
                     return *this;
                 }
             }
-            if (mNode->mLeft) {
-                mNode = mNode->mRight;
-                while (mNode->mRight) mNode = mNode->mRight;
-            } else {
-                while (mNode->mParent && mNode->mParent->mLeft == mNode) mNode = mNode->mParent;
-                mNode = mNode->mParent;
-            }
+            mNode = mNode->mPrev;
             return *this;
         }
 
@@ -469,14 +1551,15 @@ namespace aisdi {
             return !(*this == other);
         }
 
-    private:
-        const TreeMap& mMap; // wskaźnik na drzewo
+    protected:
+        const TreeMap* mMap; // wskaźnik na drzewo
         TreeNode* mNode; // aktualnie wskazywany węzeł
         bool mEnd; // czy końcowy?
     };
 
-    template<typename KeyType, typename ValueType>
-    class TreeMap<KeyType, ValueType>::Iterator : public TreeMap<KeyType, ValueType>::ConstIterator {
+    template<typename KeyType, typename ValueType, typename Compare, typename Aggregate>
+    class TreeMap<KeyType, ValueType, Compare, Aggregate>::Iterator
+            : public TreeMap<KeyType, ValueType, Compare, Aggregate>::ConstIterator {
     public:
         using reference = typename TreeMap::reference;
         using pointer = typename TreeMap::value_type*;
@@ -514,10 +1597,16 @@ namespace aisdi {
 
         reference operator*() const {
             // ugly cast, yet reduces code duplication.
-            return const_cast<reference>(ConstIterator::operator*());
+            reference item = const_cast<reference>(ConstIterator::operator*());
+            TreeMap::touch(this->mNode);//wartość może zostać zmieniona przez referencję
+            return item;
         }
     };
 
+    //Drzewo przedziałów [początek, koniec) kluczowanych początkiem (jeden przedział na początek):
+    template<typename Point, typename Compare = std::less<Point>>
+    using IntervalMap = TreeMap<Point, Point, Compare, MaxAggregate<Point>>;
+
 }
 
 #endif /* AISDI_MAPS_MAP_H */
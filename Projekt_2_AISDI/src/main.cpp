@@ -1,11 +1,23 @@
 #include <cstddef>
+#include <cstdint>
 #include <cstdlib>
+#include <cstdio>
 #include <string>
 #include <chrono>
 #include <random>
 #include <iostream>
+#include <vector>
+#include <algorithm>
+#include <mutex>
+#include <thread>
 #include "TreeMap.h"
+#include "CompactTreeMap.h"
+#include "PersistentTreeMap.h"
+#include "BTreeMap.h"
+#include "RadixTreeMap.h"
+#include "ConcurrentSkipListMap.h"
 #include "HashMap.h"
+#include "DiskHashMap.h"
 
 template<class Collection>
 void randInsert(int n) {
@@ -34,8 +46,455 @@ void randAccess(int n) {
     auto diff = End - Start;
     std::cout << "Random Access: Elements "<<n<<", Time: "<<std::chrono::duration <double, std::nano> (diff).count() << " ns" << std::endl;
 }
+//Te same wyszukiwania co w randAccess, ale przeplatane przez findMany:
+template<class Collection>
+void randAccessBatch(int n) {
+    Collection map;
+    for (int i = 0; i < n; ++i) {
+        map[i] = i;
+    }
+
+    std::mt19937 seed;
+    std::uniform_int_distribution<int> distribution(0, n);
+    std::vector<int> keys;
+    for (int i = 0; i < n; ++i)
+        keys.push_back(distribution(seed));
+    std::vector<typename Collection::const_iterator> found;
+    found.reserve(n);
+    auto Start = std::chrono::steady_clock::now();
+    map.findMany(keys.begin(), keys.end(), std::back_inserter(found));
+    auto End = std::chrono::steady_clock::now();
+    auto diff = End - Start;
+    std::cout << "Random Access (batched): Elements "<<n<<", Time: "<<std::chrono::duration <double, std::nano> (diff).count() << " ns" << std::endl;
+}
+
+//randAccess dla mapy z liczbą wiaderek równą liczbie elementów (krótkie łańcuchy - liczy się
+//koszt wyznaczenia indeksu wiaderka) i daną polityką indeksowania:
+template<class IndexPolicy>
+void indexPolicyAccess(int n, const char* name) {
+    aisdi::HashMap<int, int, IndexPolicy> map(n);
+    for (int i = 0; i < n; ++i) {
+        map[i] = i;
+    }
+
+    std::mt19937 seed;
+    std::uniform_int_distribution<int> distribution(0, n);
+    auto Start = std::chrono::steady_clock::now();
+    for(int i =0; i < n; ++i){
+        map[distribution(seed)];
+    }
+    auto End = std::chrono::steady_clock::now();
+    auto diff = End - Start;
+    std::cout << "Random Access (" << name << "): Elements "<<n<<", Time: "<<std::chrono::duration <double, std::nano> (diff).count() << " ns" << std::endl;
+}
+
+//Wczytanie posortowanych danych: kolejne wstawienia vs buildFromSorted, kopia drzewa:
+void treeSortedLoad(int n) {
+    std::vector<std::pair<int, int>> items;
+    for (int i = 0; i < n; ++i)
+        items.push_back(std::make_pair(i, i));
+
+    auto Start = std::chrono::steady_clock::now();
+    aisdi::TreeMap<int, int> inserted;
+    for (auto&& item : items)
+        inserted[item.first] = item.second;
+    auto End = std::chrono::steady_clock::now();
+    std::cout << "Sorted load (insert): Elements "<<n<<", Time: "<<std::chrono::duration <double, std::nano> (End - Start).count() << " ns" << std::endl;
+
+    Start = std::chrono::steady_clock::now();
+    auto built = aisdi::TreeMap<int, int>::buildFromSorted(items.begin(), items.end());
+    End = std::chrono::steady_clock::now();
+    std::cout << "Sorted load (buildFromSorted): Elements "<<n<<", Time: "<<std::chrono::duration <double, std::nano> (End - Start).count() << " ns" << std::endl;
+
+    Start = std::chrono::steady_clock::now();
+    aisdi::TreeMap<int, int> copy(built);
+    End = std::chrono::steady_clock::now();
+    std::cout << "Copy: Elements "<<n<<", Time: "<<std::chrono::duration <double, std::nano> (End - Start).count() << " ns" << std::endl;
+}
+
+//Usunięcie mapy z n losowymi kluczami: wartości bez destruktora (same bloki puli) i napisy
+//na stercie (destruktor każdej pary):
+void treeDestruction(int n) {
+    std::mt19937 seed;
+    std::uniform_int_distribution<int> distribution(0, 10 * n);
+    aisdi::TreeMap<int, int> numbers;
+    aisdi::TreeMap<int, std::string> texts;
+    for (int i = 0; i < n; ++i) {
+        int key = distribution(seed);
+        numbers[key] = i;
+        texts[key] = std::string(32, 'a' + i % 26);
+    }
+
+    auto Start = std::chrono::steady_clock::now();
+    numbers.clear();
+    auto End = std::chrono::steady_clock::now();
+    std::cout << "Clear (int values): Elements "<<n<<", Time: "<<std::chrono::duration <double, std::nano> (End - Start).count() << " ns" << std::endl;
+
+    Start = std::chrono::steady_clock::now();
+    texts.clear();
+    End = std::chrono::steady_clock::now();
+    std::cout << "Clear (string values): Elements "<<n<<", Time: "<<std::chrono::duration <double, std::nano> (End - Start).count() << " ns" << std::endl;
+}
+
+//Wygaszanie najstarszych wpisów (klucz to czas): 10% elementów przez remove po kolei vs eraseRange,
+//a potem co drugi z pozostałych przez removeIf:
+void treeExpiry(int n) {
+    aisdi::TreeMap<int, int> removed, erased;
+    for (int i = 0; i < n; ++i)
+        removed[i] = erased[i] = i;
+
+    auto Start = std::chrono::steady_clock::now();
+    for (int i = 0; i < n / 10; ++i)
+        removed.remove(i);
+    auto End = std::chrono::steady_clock::now();
+    std::cout << "Expiry (remove): Elements "<<n<<", Time: "<<std::chrono::duration <double, std::nano> (End - Start).count() << " ns" << std::endl;
+
+    Start = std::chrono::steady_clock::now();
+    erased.eraseRange(0, n / 10);
+    End = std::chrono::steady_clock::now();
+    std::cout << "Expiry (eraseRange): Elements "<<n<<", Time: "<<std::chrono::duration <double, std::nano> (End - Start).count() << " ns"
+              << (erased.getSize() == removed.getSize() ? "" : " (mismatch)") << std::endl;
+
+    Start = std::chrono::steady_clock::now();
+    erased.removeIf([](const std::pair<const int, int>& item) { return item.first % 2 == 0; });
+    End = std::chrono::steady_clock::now();
+    std::cout << "Expiry (removeIf): Elements "<<n<<", Time: "<<std::chrono::duration <double, std::nano> (End - Start).count() << " ns" << std::endl;
+}
+
+//Strumień prawie posortowanych kluczy: operator[] vs wstawianie ze wskazówką (poprzedni element):
+void treeNearlySortedInsert(int n) {
+    std::mt19937 seed;
+    std::uniform_int_distribution<int> jitter(0, 15);
+    std::vector<int> keys;
+    for (int i = 0; i < n; ++i)
+        keys.push_back(4 * i + jitter(seed));
+
+    auto Start = std::chrono::steady_clock::now();
+    aisdi::TreeMap<int, int> plain;
+    for (int i = 0; i < n; ++i)
+        plain[keys[i]] = i;
+    auto End = std::chrono::steady_clock::now();
+    std::cout << "Nearly sorted (operator[]): Elements "<<n<<", Time: "<<std::chrono::duration <double, std::nano> (End - Start).count() << " ns" << std::endl;
+
+    Start = std::chrono::steady_clock::now();
+    aisdi::TreeMap<int, int> hinted;
+    auto hint = hinted.end();
+    for (int i = 0; i < n; ++i)
+        hint = hinted.insert(hint, keys[i], i);
+    End = std::chrono::steady_clock::now();
+    std::cout << "Nearly sorted (hinted insert): Elements "<<n<<", Time: "<<std::chrono::duration <double, std::nano> (End - Start).count() << " ns" << std::endl;
+}
+
+//Scalanie dwóch map po n losowych kluczy: wstawianie element po elemencie vs unionWith:
+void treeMerge(int n) {
+    std::mt19937 seed;
+    std::uniform_int_distribution<int> distribution(0, 4 * n);
+    aisdi::TreeMap<int, int> first, second;
+    for (int i = 0; i < n; ++i) {
+        first[distribution(seed)] = i;
+        second[distribution(seed)] = i;
+    }
+
+    aisdi::TreeMap<int, int> inserted(first);
+    auto Start = std::chrono::steady_clock::now();
+    for (auto&& item : second)
+        inserted[item.first] = item.second;
+    auto End = std::chrono::steady_clock::now();
+    std::cout << "Merge (insert): Elements "<<n<<", Time: "<<std::chrono::duration <double, std::nano> (End - Start).count() << " ns" << std::endl;
+
+    for (bool parallel : { false, true }) {
+        aisdi::TreeMap<int, int> united(first), other(second);
+        Start = std::chrono::steady_clock::now();
+        united.unionWith(std::move(other), parallel);
+        End = std::chrono::steady_clock::now();
+        std::cout << "Merge (unionWith" << (parallel ? ", parallel" : "") << "): Elements "<<n<<", Time: "
+                  <<std::chrono::duration <double, std::nano> (End - Start).count() << " ns" << std::endl;
+    }
+}
+
+//Sumy wartości w losowych przedziałach czasu (średnio n/3 elementów): przejście po przedziale vs aggregate:
+void treeRangeSum(int n) {
+    aisdi::TreeMap<int, long, std::less<int>, aisdi::SumAggregate<long>> map;
+    for (int i = 0; i < n; ++i)
+        map[i] = i % 100;
+
+    std::mt19937 seed;
+    std::uniform_int_distribution<int> distribution(0, n);
+    std::vector<std::pair<int, int>> ranges;
+    for (int i = 0; i < 1000; ++i) {
+        int lo = distribution(seed), hi = distribution(seed);
+        ranges.push_back(std::make_pair(std::min(lo, hi), std::max(lo, hi)));
+    }
 
+    const auto& view = map;//stały dostęp nie oznacza wartości jako zmienionych
+    long sum = 0;
+    auto Start = std::chrono::steady_clock::now();
+    for (auto&& range : ranges)
+        view.forEachInRange(range.first, range.second, [&sum](const std::pair<const int, long>& item) {
+            sum += item.second;
+        });
+    auto End = std::chrono::steady_clock::now();
+    std::cout << "Range sum (iteration): Elements "<<n<<", Time: "<<std::chrono::duration <double, std::nano> (End - Start).count() << " ns" << std::endl;
+
+    Start = std::chrono::steady_clock::now();
+    for (auto&& range : ranges)
+        sum -= map.aggregate(range.first, range.second);
+    End = std::chrono::steady_clock::now();
+    std::cout << "Range sum (aggregate): Elements "<<n<<", Time: "<<std::chrono::duration <double, std::nano> (End - Start).count() << " ns"
+              << (sum == 0 ? "" : " (mismatch)") << std::endl;
+}
+
+//Pełne przejście po mapie zbudowanej w losowej kolejności (węzły sąsiadów rozrzucone w pamięci):
+//naprzód i wstecz po liście następników, dla porównania - kopia (węzły ułożone w pamięci w porządku kluczy):
+void treeFullScan(int n) {
+    aisdi::TreeMap<int, int> map;
+    std::mt19937 seed;
+    std::uniform_int_distribution<int> distribution(0, 10 * n);
+    for (int i = 0; i < n; ++i)
+        map[distribution(seed)] = i;
+
+    const auto& view = map;
+    const int rounds = 10;
+    long sum = 0;
+    auto Start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; ++round)
+        for (auto&& item : view)
+            sum += item.second;
+    auto End = std::chrono::steady_clock::now();
+    std::cout << "Full scan (forward): Elements "<<map.getSize()<<", Time: "<<std::chrono::duration <double, std::nano> (End - Start).count() / rounds << " ns" << std::endl;
+
+    Start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; ++round)
+        for (auto it = view.end(); it != view.begin();)
+            sum -= (--it)->second;
+    End = std::chrono::steady_clock::now();
+    std::cout << "Full scan (backward): Elements "<<map.getSize()<<", Time: "<<std::chrono::duration <double, std::nano> (End - Start).count() / rounds << " ns"
+              << (sum == 0 ? "" : " (mismatch)") << std::endl;
+
+    const auto copy = map;
+    Start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; ++round)
+        for (auto&& item : copy)
+            sum += item.second;
+    End = std::chrono::steady_clock::now();
+    std::cout << "Full scan (copy): Elements "<<map.getSize()<<", Time: "<<std::chrono::duration <double, std::nano> (End - Start).count() / rounds << " ns"
+              << (sum != 0 ? "" : " (empty)") << std::endl;
+}
+
+//Wyszukiwania losowych kluczy (połowa chybionych) w mapie z n kluczami z keyOf:
+template<class Map, class KeyOf>
+void lookupTime(int n, KeyOf keyOf, const char* name) {
+    Map map;
+    std::mt19937_64 seed;
+    std::vector<typename Map::key_type> keys;
+    for (int i = 0; i < n; ++i) {
+        keys.push_back(keyOf(seed()));
+        map[keys.back()] = i;
+        keys.push_back(keyOf(seed()));
+    }
+    std::shuffle(keys.begin(), keys.end(), seed);
+
+    std::size_t found = 0;
+    auto Start = std::chrono::steady_clock::now();
+    for (auto&& key : keys)
+        if (map.find(key) != map.end())
+            ++found;
+    auto End = std::chrono::steady_clock::now();
+    std::cout << "Lookup ("<<name<<"): Elements "<<n<<", Time: "<<std::chrono::duration <double, std::nano> (End - Start).count() << " ns"
+              << (found != 0 ? "" : " (nothing found)") << std::endl;
+}
+//Klucze uint64_t i napisy ze wspólnym przedrostkiem - porównania kluczy (TreeMap) vs bajty klucza (RadixTreeMap):
+void radixLookup(int n) {
+    auto number = [](std::uint64_t pRandom) { return pRandom; };
+    auto text = [](std::uint64_t pRandom) { return "user:" + std::to_string(pRandom % 100000000); };
+    lookupTime<aisdi::TreeMap<std::uint64_t, int>>(n, number, "uint64, TreeMap");
+    lookupTime<aisdi::RadixTreeMap<std::uint64_t, int>>(n, number, "uint64, RadixTreeMap");
+    lookupTime<aisdi::TreeMap<std::string, int>>(n, text, "string, TreeMap");
+    lookupTime<aisdi::RadixTreeMap<std::string, int>>(n, text, "string, RadixTreeMap");
+}
+
+//Dzierżawy [początek, koniec) o długości do 100: przedziały nachodzące na losowe okna - przegląd wszystkich
+//przedziałów vs findOverlapping:
+void intervalOverlaps(int n) {
+    aisdi::IntervalMap<int> map;
+    std::mt19937 seed;
+    std::uniform_int_distribution<int> length(1, 100);
+    for (int i = 0; i < n; ++i)
+        map[10 * i] = 10 * i + length(seed);
+
+    std::uniform_int_distribution<int> distribution(0, 10 * n);
+    std::vector<int> windows;
+    for (int i = 0; i < 1000; ++i)
+        windows.push_back(distribution(seed));
+
+    const auto& view = map;
+    long count = 0;
+    auto Start = std::chrono::steady_clock::now();
+    for (int lo : windows)
+        for (auto&& interval : view)
+            if (interval.first < lo + 50 && lo < interval.second)
+                ++count;
+    auto End = std::chrono::steady_clock::now();
+    std::cout << "Overlaps (scan): Elements "<<n<<", Time: "<<std::chrono::duration <double, std::nano> (End - Start).count() << " ns" << std::endl;
 
+    Start = std::chrono::steady_clock::now();
+    for (int lo : windows)
+        view.findOverlapping(lo, lo + 50, [&count](const std::pair<const int, int>&) { --count; });
+    End = std::chrono::steady_clock::now();
+    std::cout << "Overlaps (findOverlapping): Elements "<<n<<", Time: "<<std::chrono::duration <double, std::nano> (End - Start).count() << " ns"
+              << (count == 0 ? "" : " (mismatch)") << std::endl;
+}
+
+//Losowe wyszukiwania (połowa chybionych): drzewo vs jego zamrożona migawka:
+void treeFrozenAccess(int n) {
+    aisdi::TreeMap<int, int> map;
+    for (int i = 0; i < n; ++i)
+        map[2 * i] = i;
+    auto frozen = map.freeze();
+
+    std::mt19937 seed;
+    std::uniform_int_distribution<int> distribution(0, 2 * n);
+    std::vector<int> keys;
+    for (int i = 0; i < n; ++i)
+        keys.push_back(distribution(seed));
+
+    long sum = 0;
+    auto Start = std::chrono::steady_clock::now();
+    for (int key : keys) {
+        auto it = map.find(key);
+        if (it != map.end())
+            sum += it->second;
+    }
+    auto End = std::chrono::steady_clock::now();
+    std::cout << "Frozen lookup (TreeMap): Elements "<<n<<", Time: "<<std::chrono::duration <double, std::nano> (End - Start).count() << " ns" << std::endl;
+
+    Start = std::chrono::steady_clock::now();
+    for (int key : keys) {
+        auto it = frozen.find(key);
+        if (it != frozen.end())
+            sum -= it->second;
+    }
+    End = std::chrono::steady_clock::now();
+    std::cout << "Frozen lookup (FrozenMap): Elements "<<n<<", Time: "<<std::chrono::duration <double, std::nano> (End - Start).count() << " ns"
+              << (sum == 0 ? "" : " (mismatch)") << std::endl;
+}
+
+//Wstawianie losowych kluczy do mapy trwałej: bez migawek i z migawką po każdym wstawieniu
+//(wszystkie wersje żyją do końca - pamięć rośnie o ścieżkę na wersję):
+void persistentInsertSnapshot(int n) {
+    std::mt19937 seed;
+    std::uniform_int_distribution<int> distribution(0, n);
+    std::vector<int> keys;
+    for (int i = 0; i < n; ++i)
+        keys.push_back(distribution(seed));
+
+    auto Start = std::chrono::steady_clock::now();
+    aisdi::PersistentTreeMap<int, int> plain;
+    for (int i = 0; i < n; ++i)
+        plain.insert(keys[i], i);
+    auto End = std::chrono::steady_clock::now();
+    std::cout << "Persistent insert: Elements "<<n<<", Time: "<<std::chrono::duration <double, std::nano> (End - Start).count() << " ns" << std::endl;
+
+    Start = std::chrono::steady_clock::now();
+    aisdi::PersistentTreeMap<int, int> map;
+    std::vector<aisdi::PersistentTreeMap<int, int>> versions;
+    versions.reserve(n);
+    for (int i = 0; i < n; ++i) {
+        map.insert(keys[i], i);
+        versions.push_back(map.snapshot());
+    }
+    End = std::chrono::steady_clock::now();
+    std::cout << "Persistent insert + snapshot: Elements "<<n<<", Time: "<<std::chrono::duration <double, std::nano> (End - Start).count() << " ns" << std::endl;
+}
+
+//Czas pThreads wątków wykonujących razem pOperations operacji na kluczach z [0, pKeys):
+//pOperation(read, key) - odczyt z prawdopodobieństwem pReadPercent %, inaczej zapis.
+template<class Operation>
+double timeThreads(unsigned pThreads, int pOperations, int pReadPercent, int pKeys, Operation pOperation) {
+    std::vector<std::thread> threads;
+    auto Start = std::chrono::steady_clock::now();
+    for (unsigned t = 0; t < pThreads; ++t)
+        threads.emplace_back([=]() {
+            std::mt19937 seed(t);
+            std::uniform_int_distribution<int> keys(0, pKeys - 1);
+            std::uniform_int_distribution<int> percent(0, 99);
+            for (int i = 0; i < pOperations / static_cast<int>(pThreads); ++i) {
+                bool read = percent(seed) < pReadPercent;
+                pOperation(read, keys(seed));
+            }
+        });
+    for (auto&& thread : threads)
+        thread.join();
+    auto End = std::chrono::steady_clock::now();
+    return std::chrono::duration <double, std::nano> (End - Start).count();
+}
+
+//Skalowanie z liczbą wątków: lista z przeskokami vs TreeMap za jednym muteksem, przy różnych
+//udziałach odczytów (zapis to wstawienie albo usunięcie, więc rozmiar mapy zostaje około n/2):
+void concurrentScaling(int n) {
+    const int operations = 400000;
+    unsigned maxThreads = std::max(4u, std::thread::hardware_concurrency());
+    for (int readPercent : { 100, 90, 50 }) {
+        for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+            aisdi::ConcurrentSkipListMap<int, int> skipList;
+            aisdi::TreeMap<int, int> tree;
+            std::mutex treeMutex;
+            for (int i = 0; i < n; i += 2) {
+                skipList.upsert(i, i);
+                tree[i] = i;
+            }
+
+            double time = timeThreads(threads, operations, readPercent, n, [&skipList](bool read, int key) {
+                int value;
+                if (read)
+                    skipList.find(key, value);
+                else if (!skipList.remove(key))
+                    skipList.upsert(key, key);
+            });
+            std::cout << "Concurrent (skip list, " << readPercent << "% reads, " << threads << " threads): Elements "<<n
+                      <<", Time: "<<time<< " ns" << std::endl;
+
+            time = timeThreads(threads, operations, readPercent, n, [&tree, &treeMutex](bool read, int key) {
+                std::lock_guard<std::mutex> guard(treeMutex);
+                if (read)
+                    tree.find(key);
+                else if (tree.find(key) != tree.end())
+                    tree.remove(key);
+                else
+                    tree[key] = key;
+            });
+            std::cout << "Concurrent (locked TreeMap, " << readPercent << "% reads, " << threads << " threads): Elements "<<n
+                      <<", Time: "<<time<< " ns" << std::endl;
+        }
+    }
+}
+
+//Mapa dyskowa: czas i liczba operacji wejścia/wyjścia na operację (pamięć podręczna 16 stron):
+void diskRandInsertAccess(int n) {
+    const char* path = "aisdi_disk_map.bin";
+    {
+        aisdi::DiskHashMap<int, int> map(path, 16);
+        std::mt19937 seed;
+        std::uniform_int_distribution<int> distribution(0, n);
+        auto Start = std::chrono::steady_clock::now();
+        for (int i = 0; i < n; ++i)
+            map.insert(distribution(seed), i);
+        auto End = std::chrono::steady_clock::now();
+        double io = map.getReads() + map.getWrites();
+        std::cout << "DiskHashMap: Elements "<<n<<", Time: "<<std::chrono::duration <double, std::nano> (End - Start).count()
+                  << " ns, I/O per insert: " << io / n << std::endl;
+
+        int value;
+        Start = std::chrono::steady_clock::now();
+        for (int i = 0; i < n; ++i)
+            map.find(distribution(seed), value);
+        End = std::chrono::steady_clock::now();
+        io = map.getReads() + map.getWrites() - io;
+        std::cout << "Random Access: Elements "<<n<<", Time: "<<std::chrono::duration <double, std::nano> (End - Start).count()
+                  << " ns, I/O per access: " << io / n << std::endl;
+    }
+    std::remove(path);
+}
 
 int main(int argc, char** argv)
 {
@@ -51,13 +510,50 @@ int main(int argc, char** argv)
       diff = End - Start;
       std::cout << "HashMap: Elements "<<i<<", Time: "<<std::chrono::duration <double, std::nano> (diff).count() << " ns" << std::endl;
       randAccess<aisdi::HashMap<int, int>>(i);
+      randAccessBatch<aisdi::HashMap<int, int>>(i);
+      indexPolicyAccess<aisdi::ModuloIndex>(i, "modulo");
+      indexPolicyAccess<aisdi::PowerOfTwoIndex>(i, "power of two");
+      indexPolicyAccess<aisdi::FastRangeIndex>(i, "fastrange");
+      indexPolicyAccess<aisdi::PrimeIndex>(i, "prime");
       Start = std::chrono::steady_clock::now();
       randInsert<aisdi::TreeMap<int, int>>(i);
       End = std::chrono::steady_clock::now();
       diff = End - Start;
       std::cout << "TreeMap: Elements "<<i<<", Time: "<<std::chrono::duration <double, std::nano> (diff).count() << " ns" << std::endl;
-      randAccess<aisdi::HashMap<int, int>>(i);
+      randAccess<aisdi::TreeMap<int, int>>(i);
+      treeSortedLoad(i);
+      treeMerge(i);
+      treeNearlySortedInsert(i);
+      treeFrozenAccess(i);
+      treeFullScan(i);
+      treeDestruction(i);
+      treeExpiry(i);
+      treeRangeSum(i);
+      intervalOverlaps(i);
+      persistentInsertSnapshot(i);
+      Start = std::chrono::steady_clock::now();
+      randInsert<aisdi::CompactTreeMap<int, int>>(i);
+      End = std::chrono::steady_clock::now();
+      diff = End - Start;
+      std::cout << "CompactTreeMap: Elements "<<i<<", Time: "<<std::chrono::duration <double, std::nano> (diff).count() << " ns" << std::endl;
+      randAccess<aisdi::CompactTreeMap<int, int>>(i);
+      Start = std::chrono::steady_clock::now();
+      randInsert<aisdi::BTreeMap<int, int>>(i);
+      End = std::chrono::steady_clock::now();
+      diff = End - Start;
+      std::cout << "BTreeMap: Elements "<<i<<", Time: "<<std::chrono::duration <double, std::nano> (diff).count() << " ns" << std::endl;
+      randAccess<aisdi::BTreeMap<int, int>>(i);
+      Start = std::chrono::steady_clock::now();
+      randInsert<aisdi::RadixTreeMap<int, int>>(i);
+      End = std::chrono::steady_clock::now();
+      diff = End - Start;
+      std::cout << "RadixTreeMap: Elements "<<i<<", Time: "<<std::chrono::duration <double, std::nano> (diff).count() << " ns" << std::endl;
+      randAccess<aisdi::RadixTreeMap<int, int>>(i);
+      radixLookup(i);
+      diskRandInsertAccess(i);
   }
+  treeDestruction(1000000);
+  concurrentScaling(100000);
 
   return 0;
 }
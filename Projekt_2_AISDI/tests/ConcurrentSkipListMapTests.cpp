@@ -0,0 +1,217 @@
+#include <ConcurrentSkipListMap.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <map>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/mpl/list.hpp>
+
+using TestedKeyTypes = boost::mpl::list<std::int32_t, std::uint64_t>;
+
+template <typename K>
+using Map = aisdi::ConcurrentSkipListMap<K, std::string>;
+
+BOOST_AUTO_TEST_SUITE(ConcurrentSkipListMapTests)
+
+template <typename K>
+std::vector<std::pair<K, std::string>> itemsInRange(const Map<K>& map, K lo, K hi)
+{
+  std::vector<std::pair<K, std::string>> items;
+  map.forEachInRange(lo, hi, [&items](const typename Map<K>::value_type& item) {
+    items.push_back(std::make_pair(item.first, item.second));
+  });
+  return items;
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenCreatedWithDefaultConstructor_ThenItIsEmpty,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map;
+
+  BOOST_CHECK(map.isEmpty());
+  BOOST_CHECK(!map.contains(K{}));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenUpsertingExistingKey_ThenValueIsReplaced,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+
+  BOOST_CHECK(map.upsert(7, "a"));
+  BOOST_CHECK(!map.upsert(7, "b"));
+
+  std::string value;
+  BOOST_REQUIRE(map.find(7, value));
+  BOOST_CHECK_EQUAL(value, "b");
+  BOOST_CHECK_EQUAL(map.getSize(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenRemovingKeys_ThenOnlyExistingOnesAreRemoved,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  map.upsert(1, "1");
+  map.upsert(2, "2");
+
+  BOOST_CHECK(map.remove(1));
+  BOOST_CHECK(!map.remove(1));
+  BOOST_CHECK(!map.remove(3));
+  BOOST_CHECK(!map.contains(1));
+  BOOST_CHECK(map.contains(2));
+  BOOST_CHECK_EQUAL(map.getSize(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenInsertingAndRemovingManyItems_ThenRangeScanMatchesStdMap,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  std::map<K, std::string> expected;
+  std::mt19937 random;
+
+  for (int i = 0; i < 3000; ++i)
+  {
+    const K key = static_cast<K>(random() % 500);
+    if (random() % 3 == 0)
+      BOOST_REQUIRE_EQUAL(map.remove(key), expected.erase(key) == 1);
+    else
+    {
+      const bool added = expected.count(key) == 0;
+      expected[key] = std::to_string(i);
+      BOOST_REQUIRE_EQUAL(map.upsert(key, std::to_string(i)), added);
+    }
+  }
+
+  const auto items = itemsInRange<K>(map, 100, 400);
+  const std::vector<std::pair<K, std::string>> expectedItems(expected.lower_bound(100), expected.lower_bound(400));
+  BOOST_CHECK(items == expectedItems);
+  BOOST_CHECK_EQUAL(map.getSize(), expected.size());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenManyWriterThreads_WhenInsertingDisjointKeys_ThenAllKeysArePresent,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  const int threadCount = 4;
+  const int perThread = 2000;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < threadCount; ++t)
+    threads.emplace_back([&map, t]() {
+      for (int i = 0; i < perThread; ++i)
+        map.upsert(static_cast<K>(i * threadCount + t), std::to_string(t));
+    });
+  for (auto& thread : threads)
+    thread.join();
+
+  BOOST_CHECK_EQUAL(map.getSize(), static_cast<std::size_t>(threadCount * perThread));
+  const auto items = itemsInRange<K>(map, 0, threadCount * perThread);
+  BOOST_REQUIRE_EQUAL(items.size(), static_cast<std::size_t>(threadCount * perThread));
+  for (std::size_t i = 0; i < items.size(); ++i)
+  {
+    BOOST_REQUIRE_EQUAL(items[i].first, static_cast<K>(i));
+    BOOST_CHECK_EQUAL(items[i].second, std::to_string(i % threadCount));
+  }
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenReadersAndWriters_WhenRunningConcurrently_ThenReadersSeeStableKeysAndOrder,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  for (K i = 0; i < 1000; ++i)
+    map.upsert(2 * i, "stable");
+
+  bool consistent = true;
+  std::thread reader([&map, &consistent]() {
+    for (int round = 0; round < 50; ++round)
+    {
+      std::string value;
+      for (K i = 0; i < 1000; i += 7)
+        consistent = consistent && map.find(2 * i, value) && value == "stable";
+      K previous = 0;
+      bool first = true;
+      map.forEachInRange(0, 2000, [&](const typename Map<K>::value_type& item) {
+        consistent = consistent && (first || previous < item.first);
+        previous = item.first;
+        first = false;
+      });
+    }
+  });
+  std::thread writer([&map]() {
+    for (int round = 0; round < 5; ++round)
+      for (K i = 0; i < 1000; ++i)
+      {
+        if (round % 2 == 0)
+          map.upsert(2 * i + 1, "odd");
+        else
+          map.remove(2 * i + 1);
+      }
+  });
+  reader.join();
+  writer.join();
+
+  BOOST_CHECK(consistent);
+  BOOST_CHECK_EQUAL(map.getSize(), 2000u);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenWritersChurningKeysWhileReading_WhenTheyFinish_ThenLastWritesAreVisible,
+                              K,
+                              TestedKeyTypes)
+{
+  //Wiele usunięć przy trwających odczytach - usunięte węzły są zwalniane w trakcie pracy mapy:
+  Map<K> map;
+  const int threadCount = 3;
+  const int keysPerThread = 200;
+  bool ordered = true;
+  std::atomic<bool> done(false);
+
+  std::thread reader([&map, &ordered, &done]() {
+    while (!done.load())
+    {
+      K previous = 0;
+      bool first = true;
+      map.forEachInRange(0, threadCount * keysPerThread, [&](const typename Map<K>::value_type& item) {
+        ordered = ordered && (first || previous < item.first) && item.second == std::to_string(item.first);
+        previous = item.first;
+        first = false;
+      });
+    }
+  });
+  std::vector<std::thread> writers;
+  for (int t = 0; t < threadCount; ++t)
+    writers.emplace_back([&map, t]() {
+      for (int round = 0; round < 20; ++round)
+        for (int i = 0; i < keysPerThread; ++i)
+        {
+          const K key = static_cast<K>(i * threadCount + t);
+          if (round % 2 == 0 || i % 4 == 0)
+            map.upsert(key, std::to_string(key));
+          else
+            map.remove(key);
+        }
+    });
+  for (auto& writer : writers)
+    writer.join();
+  done.store(true);
+  reader.join();
+
+  BOOST_CHECK(ordered);
+  const auto items = itemsInRange<K>(map, 0, threadCount * keysPerThread);
+  BOOST_REQUIRE_EQUAL(items.size(), static_cast<std::size_t>(threadCount * keysPerThread / 4));
+  for (std::size_t i = 0; i < items.size(); ++i)
+    BOOST_CHECK_EQUAL(items[i].first, static_cast<K>(i / threadCount * 4 * threadCount + i % threadCount));
+  BOOST_CHECK_EQUAL(map.getSize(), items.size());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,129 @@
+#include <DiskHashMap.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <map>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/mpl/list.hpp>
+
+using TestedKeyTypes = boost::mpl::list<std::int32_t, std::uint64_t>;
+
+template <typename K>
+using Map = aisdi::DiskHashMap<K, double>;
+
+namespace
+{
+const char* const TestFile = "DiskHashMapTests.bin";
+
+struct CollidingHash
+{
+  std::size_t operator()(std::uint64_t) const
+  {
+    return 7;
+  }
+};
+}
+
+BOOST_AUTO_TEST_SUITE(DiskHashMapTests)
+
+template <typename K>
+void thenMapContainsItems(Map<K>& map,
+                          const std::map<K, double>& expected)
+{
+  BOOST_CHECK_EQUAL(map.getSize(), expected.size());
+
+  for (const auto& item : expected)
+  {
+    double value = 0;
+    BOOST_REQUIRE_MESSAGE(map.find(item.first, value), "Missing required item with key: " << item.first);
+    BOOST_CHECK_EQUAL(value, item.second);
+  }
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenCreated_ThenItIsEmpty,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map(TestFile);
+
+  BOOST_CHECK(map.isEmpty());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenGettingValueOfMissingKey_ThenExceptionIsThrown,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map(TestFile);
+
+  BOOST_CHECK_THROW(map.valueOf(42), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenInsertingExistingKey_ThenValueIsReplaced,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map(TestFile);
+  map.insert(42, 1.5);
+
+  map.insert(42, 2.5);
+
+  BOOST_CHECK_EQUAL(map.getSize(), 1u);
+  BOOST_CHECK_EQUAL(map.valueOf(42), 2.5);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenRemovingMissingKey_ThenExceptionIsThrown,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map(TestFile);
+  map.insert(42, 1.5);
+
+  BOOST_CHECK_THROW(map.remove(27), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapLargerThanCache_WhenInsertingAndRemoving_ThenAllItemsAreKept,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map(TestFile, 4);
+  std::map<K, double> expected;
+  for (K i = 0; i < 20000; ++i)
+  {
+    map.insert(i, i / 2.0);
+    expected[i] = i / 2.0;
+  }
+  for (K i = 0; i < 20000; i += 3)
+  {
+    map.remove(i);
+    expected.erase(i);
+  }
+
+  thenMapContainsItems(map, expected);
+  BOOST_CHECK(map.getPageCount() > 4u);
+  BOOST_CHECK(map.getReads() > 0u);
+  BOOST_CHECK(map.getWrites() > 0u);
+  std::remove(TestFile);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenKeysWithTheSameHash_WhenOverflowingPage_ThenInsertThrowsAndKeepsItems,
+                              K,
+                              TestedKeyTypes)
+{
+  aisdi::DiskHashMap<K, double, CollidingHash> map(TestFile);
+  std::map<K, double> expected;
+
+  K key = 0;
+  BOOST_CHECK_THROW(for (; key < 1000; ++key) { map.insert(key, key / 2.0); expected[key] = key / 2.0; },
+                    std::length_error);
+
+  BOOST_CHECK(key > 0 && key < 1000);
+  BOOST_CHECK_EQUAL(map.getSize(), expected.size());
+  for (const auto& item : expected)
+    BOOST_CHECK_EQUAL(map.valueOf(item.first), item.second);
+  BOOST_CHECK_EQUAL(map.getPageCount(), 1u);
+  std::remove(TestFile);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -3,6 +3,9 @@
 #include <cstdint>
 #include <string>
 #include <map>
+#include <vector>
+#include <iterator>
+#include <algorithm>
 
 #include <boost/test/unit_test.hpp>
 
@@ -16,7 +19,7 @@ using Map = aisdi::HashMap<K, std::string>;
 using std::begin;
 using std::end;
 
-BOOST_AUTO_TEST_SUITE(MapsTests)
+BOOST_AUTO_TEST_SUITE(HashMapTests)
 
 template <typename K>
 void thenMapContainsItems(const Map<K>& map,
@@ -591,6 +594,450 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenTwoMapsWithDifferentKeys_WhenComparingThem_Th
   BOOST_CHECK(map != other);
 }
 
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithCollidingKeys_WhenRemovingValuesByKey_ThenOtherItemsAreKept,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  std::map<K, std::string> expected;
+  for (K i = 0; i < 200; ++i)
+  {
+    map[i] = std::to_string(i);
+    if (i % 3 != 0)
+      expected[i] = std::to_string(i);
+  }
+
+  for (K i = 0; i < 200; i += 3)
+    map.remove(i);
+
+  thenMapContainsItems(map, expected);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenErasingItemByIterator_ThenNextIteratorIsReturned,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" }, { 13, "Chuck" } };
+  auto it = begin(map);
+  auto expected = it;
+  ++expected;
+
+  auto next = map.erase(it);
+
+  BOOST_CHECK(next == expected);
+  BOOST_CHECK_EQUAL(map.getSize(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenErasingWhileIterating_ThenOnlySelectedItemsRemain,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  std::map<K, std::string> expected;
+  for (K i = 0; i < 200; ++i)
+  {
+    map[i] = std::to_string(i);
+    if (i % 2 == 0)
+      expected[i] = std::to_string(i);
+  }
+
+  for (auto it = begin(map); it != end(map);)
+  {
+    if (it->first % 2 != 0)
+      it = map.erase(it);
+    else
+      ++it;
+  }
+
+  thenMapContainsItems(map, expected);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenErasingIfPredicateHolds_ThenMatchingItemsAreRemoved,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" }, { 13, "Chuck" }, { 7, "Alice" } };
+
+  auto removed = map.eraseIf([](const std::pair<const K, std::string>& item) {
+    return item.second == "Alice";
+  });
+
+  BOOST_CHECK_EQUAL(removed, 2u);
+  thenMapContainsItems(map, { { 27, "Bob" }, { 13, "Chuck" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenSmallMap_WhenDecrementingEnd_ThenItemsAreVisitedBackToBegin,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 49, "Alice" }, { 99, "Bob" } };
+
+  auto it = end(map);
+  --it;
+  --it;
+
+  BOOST_CHECK(it == begin(map));
+  BOOST_CHECK_THROW(--it, std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithItemsInLastBucket_WhenDecrementingEnd_ThenLastBucketItemsAreReturned,
+                              K,
+                              TestedKeyTypes)
+{
+  //Więcej elementów niż SmallCapacity - mapa ma tablicę 50 wiaderek, 49 i 99 trafiają do ostatniego:
+  const K capacity = Map<K>::SmallCapacity;
+  Map<K> map = { { 49, "Alice" }, { 99, "Bob" } };
+  for (K i = 0; i < capacity; ++i)
+    map[i] = std::to_string(i);
+  BOOST_REQUIRE(map.memoryUsage().mBuckets != 0);
+
+  auto it = end(map);
+  const K last = (--it)->first;
+  const K beforeLast = (--it)->first;
+  --it;
+
+  BOOST_CHECK(std::min(last, beforeLast) == 49 && std::max(last, beforeLast) == 99);
+  BOOST_CHECK_EQUAL(it->first, capacity - 1);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenSnapshot_WhenModifyingMap_ThenSnapshotIsNotChanged,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" }, { 92, "Chuck" } };
+  const auto snapshot = map.snapshot();
+
+  map[42] = "Eve";
+  map[13] = "Dave";
+  map.remove(27);
+  map.erase(map.find(92));
+
+  thenMapContainsItems(snapshot, { { 42, "Alice" }, { 27, "Bob" }, { 92, "Chuck" } });
+  thenMapContainsItems(map, { { 42, "Eve" }, { 13, "Dave" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenSnapshot_WhenWritingThroughIterator_ThenSnapshotIsNotChanged,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+  const auto snapshot = map.snapshot();
+
+  for (auto& item : map)
+    item.second = "Eve";
+
+  thenMapContainsItems(snapshot, { { 42, "Alice" }, { 27, "Bob" } });
+  thenMapContainsItems(map, { { 42, "Eve" }, { 27, "Eve" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenSnapshot_WhenMapIsDestroyed_ThenSnapshotIsStillReadable,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K>* map = new Map<K>{ { 42, "Alice" }, { 27, "Bob" } };
+  const auto snapshot = map->snapshot();
+
+  map->eraseIf([](const std::pair<const K, std::string>&) { return true; });
+  delete map;
+
+  thenMapContainsItems(snapshot, { { 42, "Alice" }, { 27, "Bob" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenLargeMapSnapshot_WhenModifyingMap_ThenSnapshotIsNotChanged,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  std::map<K, std::string> expected;
+  for (K i = 0; i < 100; ++i)
+  {
+    map[i] = std::to_string(i);
+    expected[i] = std::to_string(i);
+  }
+  const auto snapshot = map.snapshot();
+
+  for (K i = 0; i < 100; i += 2)
+    map.remove(i);
+  map[1] = "Eve";
+
+  thenMapContainsItems(snapshot, expected);
+  BOOST_CHECK_EQUAL(map.getSize(), 50u);
+  BOOST_CHECK_EQUAL(map.valueOf(1), "Eve");
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenReferenceTakenBeforeSnapshot_WhenWritingAfterAccessingItAgain_ThenSnapshotIsNotChanged,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  for (K i = 0; i < 100; ++i)
+    map[i] = std::to_string(i);
+  auto& value = map[42];
+  auto it = map.find(27);
+  const auto snapshot = map.snapshot();
+
+  //Referencja i iterator sprzed migawki wskazują na węzły współdzielone - trzeba je pobrać ponownie:
+  BOOST_CHECK(&map[42] != &value);
+  map[42] = "Eve";
+  it = map.find(27);
+  it->second = "Mallory";
+
+  BOOST_CHECK_EQUAL(snapshot.valueOf(42), "42");
+  BOOST_CHECK_EQUAL(snapshot.valueOf(27), "27");
+  BOOST_CHECK_EQUAL(map.valueOf(42), "Eve");
+  BOOST_CHECK_EQUAL(map.valueOf(27), "Mallory");
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenSnapshot_WhenAdvancingFoundIteratorAndWriting_ThenSnapshotIsNotChanged,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  std::map<K, std::string> expected;
+  for (K i = 0; i < 1000; ++i)
+  {
+    map[i] = std::to_string(i);
+    expected[i] = std::to_string(i);
+  }
+  const auto snapshot = map.snapshot();
+
+  //Iterator z find() przechodzi do wiaderek wciąż współdzielonych z migawką:
+  for (auto it = map.find(0); it != map.end(); ++it)
+    it->second = "Eve";
+  auto it = map.end();
+  while (it != map.begin())
+    (--it)->second = "Mallory";
+
+  thenMapContainsItems(snapshot, expected);
+  for (K i = 0; i < 1000; ++i)
+    BOOST_CHECK_EQUAL(map.valueOf(i), "Mallory");
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenSmallMap_WhenAddingMoreItemsThanInlineCapacity_ThenAllItemsAreKept,
+                              K,
+                              TestedKeyTypes)
+{
+  const K capacity = Map<K>::SmallCapacity;
+  Map<K> map;
+  std::map<K, std::string> expected;
+
+  for (K i = 0; i < 3 * capacity; ++i)
+  {
+    map[i] = std::to_string(i);
+    expected[i] = std::to_string(i);
+    thenMapContainsItems(map, expected);
+  }
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenSmallMap_WhenRemovingAndAddingItems_ThenSlotsAreReused,
+                              K,
+                              TestedKeyTypes)
+{
+  const K capacity = Map<K>::SmallCapacity;
+  Map<K> map;
+  for (K i = 0; i < capacity; ++i)
+    map[i] = std::to_string(i);
+
+  map.remove(3);
+  map.remove(5);
+  map[100] = "Alice";
+  map[101] = "Bob";
+
+  BOOST_CHECK_EQUAL(map.getSize(), Map<K>::SmallCapacity);
+  BOOST_CHECK_EQUAL(map.valueOf(100), "Alice");
+  BOOST_CHECK_EQUAL(map.valueOf(101), "Bob");
+  BOOST_CHECK(map.find(3) == end(map));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenSmallAndLargeMapsWithSameItems_WhenComparingThem_ThenTheyAreEqual,
+                              K,
+                              TestedKeyTypes)
+{
+  const K capacity = Map<K>::SmallCapacity;
+  Map<K> small;
+  Map<K> large;
+  for (K i = 0; i < 4 * capacity; ++i)
+    large[i] = std::to_string(i);
+  for (K i = 4; i < 4 * capacity; ++i)
+    large.remove(i);
+  for (K i = 0; i < 4; ++i)
+    small[i] = std::to_string(i);
+
+  BOOST_CHECK(small == large);
+  BOOST_CHECK(large == small);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenFindingManyKeys_ThenIteratorsAreReturnedInOrder,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  std::vector<K> keys;
+  for (K i = 0; i < 500; ++i)
+  {
+    map[2 * i] = std::to_string(2 * i);
+    keys.push_back(i);
+  }
+  std::vector<typename Map<K>::const_iterator> found;
+
+  map.findMany(keys.begin(), keys.end(), std::back_inserter(found));
+
+  BOOST_REQUIRE_EQUAL(found.size(), keys.size());
+  for (std::size_t i = 0; i < keys.size(); ++i)
+  {
+    if (keys[i] % 2 == 0)
+    {
+      BOOST_REQUIRE(found[i] != map.cend());
+      BOOST_CHECK_EQUAL(found[i]->second, std::to_string(keys[i]));
+    }
+    else
+      BOOST_CHECK(found[i] == map.cend());
+  }
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenSmallMap_WhenFindingManyKeys_ThenIteratorsAreReturnedInOrder,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+  const std::vector<K> keys = { 27, 13, 42 };
+  std::vector<typename Map<K>::const_iterator> found;
+
+  map.findMany(keys.begin(), keys.end(), std::back_inserter(found));
+
+  BOOST_REQUIRE_EQUAL(found.size(), 3u);
+  BOOST_CHECK_EQUAL(found[0]->second, "Bob");
+  BOOST_CHECK(found[1] == map.cend());
+  BOOST_CHECK_EQUAL(found[2]->second, "Alice");
+}
+
+using TestedIndexPolicies = boost::mpl::list<aisdi::ModuloIndex, aisdi::PowerOfTwoIndex,
+                                              aisdi::FastRangeIndex, aisdi::PrimeIndex>;
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenIndexPolicy_WhenAddingAndRemovingItems_ThenAllItemsAreFound,
+                              P,
+                              TestedIndexPolicies)
+{
+  aisdi::HashMap<std::uint64_t, std::string, P> map(1000);
+  std::size_t iterated = 0;
+  for (std::uint64_t i = 0; i < 3000; ++i)
+    map[i * 7919] = std::to_string(i);
+  for (std::uint64_t i = 0; i < 3000; i += 2)
+    map.remove(i * 7919);
+
+  for (auto it = map.cbegin(); it != map.cend(); ++it)
+    ++iterated;
+
+  BOOST_CHECK_EQUAL(iterated, 1500u);
+  for (std::uint64_t i = 1; i < 3000; i += 2)
+    BOOST_CHECK_EQUAL(map.valueOf(i * 7919), std::to_string(i));
+}
+
+BOOST_AUTO_TEST_CASE(GivenIndexPolicies_WhenAskingForBucketCount_ThenItIsRoundedUp)
+{
+  BOOST_CHECK_EQUAL(aisdi::ModuloIndex(50).bucketCount(), 50u);
+  BOOST_CHECK_EQUAL(aisdi::PowerOfTwoIndex(50).bucketCount(), 64u);
+  BOOST_CHECK_EQUAL(aisdi::PowerOfTwoIndex(1).bucketCount(), 1u);
+  BOOST_CHECK_EQUAL(aisdi::FastRangeIndex(50).bucketCount(), 50u);
+  BOOST_CHECK_EQUAL(aisdi::PrimeIndex(50).bucketCount(), 53u);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenIndexPolicy_WhenComputingIndexes_ThenTheyAreWithinBucketCount,
+                              P,
+                              TestedIndexPolicies)
+{
+  const P index(1000);
+
+  for (std::size_t hash = 0; hash < 100000; hash += 7)
+    BOOST_CHECK_LT(index(hash * 2654435761u), index.bucketCount());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenSmallMap_WhenAskingForMemoryUsage_ThenNoBucketArrayIsReported,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+
+  const auto usage = map.memoryUsage();
+
+  BOOST_CHECK_EQUAL(usage.mBuckets, 0u);
+  BOOST_CHECK_EQUAL(usage.mKeys, 2 * sizeof(K));
+  BOOST_CHECK_EQUAL(usage.mValues, 2 * sizeof(std::string));
+  BOOST_CHECK_EQUAL(usage.total(), sizeof(Map<K>));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenLargeMap_WhenAskingForMemoryUsage_ThenBucketsAndNodesAreReported,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map(50);
+  for (K i = 0; i < 100; ++i)
+    map[i] = std::to_string(i);
+
+  const auto usage = map.memoryUsage();
+
+  BOOST_CHECK_EQUAL(usage.mBuckets, 50 * sizeof(void*));
+  BOOST_CHECK_EQUAL(usage.mKeys, 100 * sizeof(K));
+  BOOST_CHECK_EQUAL(usage.mValues, 100 * sizeof(std::string));
+  BOOST_CHECK(usage.mNodes >= 100 * 2 * sizeof(void*));
+  BOOST_CHECK_EQUAL(usage.mObject, sizeof(Map<K>));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithMemoryBudget_WhenInsertExceedsIt_ThenExceptionIsThrown,
+                              K,
+                              TestedKeyTypes)
+{
+  const K capacity = Map<K>::SmallCapacity;
+  Map<K> map;
+  map.setMemoryBudget(sizeof(Map<K>) + 100);
+
+  for (K i = 0; i < capacity; ++i)
+    map[i] = std::to_string(i);
+
+  BOOST_CHECK_THROW(map[100], std::length_error);
+  BOOST_CHECK_EQUAL(map.getSize(), Map<K>::SmallCapacity);
+  BOOST_CHECK(map.memoryUsage().total() <= map.getMemoryBudget());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenSmallMapWithMemoryBudget_WhenAddingItems_ThenInlineSlotsAreFree,
+                              K,
+                              TestedKeyTypes)
+{
+  const K capacity = Map<K>::SmallCapacity;
+  Map<K> map;
+  map.setMemoryBudget(sizeof(Map<K>));
+
+  for (K i = 0; i < capacity; ++i)
+    map[i] = std::to_string(i);
+
+  BOOST_CHECK_EQUAL(map.memoryUsage().total(), sizeof(Map<K>));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithMemoryBudgetAndCallback_WhenInsertExceedsIt_ThenCallbackDecides,
+                              K,
+                              TestedKeyTypes)
+{
+  const K capacity = Map<K>::SmallCapacity;
+  Map<K> map;
+  for (K i = 0; i < capacity; ++i)
+    map[i] = std::to_string(i);
+  std::size_t calls = 0;
+  bool allow = true;
+  map.setMemoryBudget(sizeof(Map<K>), [&](const Map<K>&, std::size_t expected) {
+    ++calls;
+    BOOST_CHECK(expected > sizeof(Map<K>));
+    return allow;
+  });
+
+  map[42] = "Alice";
+  allow = false;
+
+  BOOST_CHECK_THROW(map[27], std::length_error);
+  BOOST_CHECK_EQUAL(calls, 2u);
+  BOOST_CHECK_EQUAL(map.getSize(), capacity + 1);
+  BOOST_CHECK_EQUAL(map.valueOf(42), "Alice");
+}
+
 // ConstIterator is tested via Iterator methods.
 // If Iterator methods are to be changed, then new ConstIterator tests are required.
 
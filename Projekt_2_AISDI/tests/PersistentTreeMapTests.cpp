@@ -0,0 +1,171 @@
+#include <PersistentTreeMap.h>
+
+#include <cstdint>
+#include <string>
+#include <map>
+#include <random>
+#include <thread>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/mpl/list.hpp>
+
+using TestedKeyTypes = boost::mpl::list<std::int32_t, std::uint64_t>;
+
+template <typename K>
+using Map = aisdi::PersistentTreeMap<K, std::string>;
+
+using std::begin;
+using std::end;
+
+BOOST_AUTO_TEST_SUITE(PersistentTreeMapTests)
+
+template <typename K>
+void thenMapContainsItems(const Map<K>& map,
+                          const std::map<K, std::string>& expected)
+{
+  BOOST_CHECK_EQUAL(map.getSize(), expected.size());
+
+  auto it = begin(map);
+  for (const auto& item : expected)
+  {
+    BOOST_REQUIRE_MESSAGE(it != end(map), "Missing required item with key: " << item.first);
+    BOOST_CHECK_EQUAL(it->first, item.first);
+    BOOST_CHECK_EQUAL(it->second, item.second);
+    BOOST_CHECK_EQUAL(map.valueOf(item.first), item.second);
+    ++it;
+  }
+  BOOST_CHECK(it == end(map));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenCreatedWithDefaultConstructor_ThenItIsEmpty,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map;
+
+  BOOST_CHECK(map.isEmpty());
+  BOOST_CHECK(begin(map) == end(map));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenInsertingAndRemovingManyItems_ThenItemsAreKeptInOrder,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  std::map<K, std::string> expected;
+  std::mt19937 random;
+
+  for (int i = 0; i < 2000; ++i)
+  {
+    const K key = static_cast<K>(random() % 500);
+    if (random() % 3 == 0 && expected.count(key) != 0)
+    {
+      map.remove(key);
+      expected.erase(key);
+    }
+    else
+    {
+      map.insert(key, std::to_string(i));
+      expected[key] = std::to_string(i);
+    }
+  }
+
+  thenMapContainsItems(map, expected);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenSnapshot_WhenChangingMap_ThenSnapshotKeepsOldVersion,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 1, "1" }, { 2, "2" }, { 3, "3" } };
+  const Map<K> snapshot = map.snapshot();
+
+  map.insert(2, "two");
+  map.insert(4, "4");
+  map.remove(1);
+
+  thenMapContainsItems(snapshot, { { 1, "1" }, { 2, "2" }, { 3, "3" } });
+  thenMapContainsItems(map, { { 2, "two" }, { 3, "3" }, { 4, "4" } });
+  BOOST_CHECK(snapshot != map);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenManySnapshots_WhenReadingThem_ThenEachShowsItsOwnVersion,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  std::vector<Map<K>> versions;
+  for (K i = 0; i < 200; ++i)
+  {
+    versions.push_back(map.snapshot());
+    map.insert(i, std::to_string(i));
+  }
+
+  for (K i = 0; i < 200; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(versions[i].getSize(), i);
+    BOOST_CHECK(versions[i].find(i) == end(versions[i]));
+    if (i > 0)
+      BOOST_CHECK_EQUAL(versions[i].find(i - 1)->second, std::to_string(i - 1));
+  }
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenRemovingNotExistingKey_ThenExceptionIsThrown,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 1, "1" } };
+
+  BOOST_CHECK_THROW(map.remove(2), std::out_of_range);
+  BOOST_CHECK_THROW(map.valueOf(2), std::out_of_range);
+  BOOST_CHECK_EQUAL(map.getSize(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenFindingKey_ThenIterationContinuesFromIt,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  for (K i = 0; i < 100; i += 2)
+    map.insert(i, std::to_string(i));
+
+  auto it = map.find(40);
+  for (K i = 40; i < 100; i += 2, ++it)
+    BOOST_REQUIRE_EQUAL(it->first, i);
+  BOOST_CHECK(it == end(map));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenSnapshotReadInOtherThread_WhenChangingMap_ThenReaderSeesConsistentVersion,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  for (K i = 0; i < 1000; ++i)
+    map.insert(i, std::to_string(i));
+
+  const Map<K> snapshot = map.snapshot();
+  bool consistent = true;
+  std::thread reader([&snapshot, &consistent]() {
+    for (int round = 0; round < 20; ++round)
+    {
+      K expected = 0;
+      for (const auto& item : snapshot)
+        consistent = consistent && item.first == expected && item.second == std::to_string(expected++);
+      consistent = consistent && expected == 1000;
+    }
+  });
+  for (K i = 0; i < 1000; ++i)
+  {
+    if (i % 2 == 0)
+      map.remove(i);
+    else
+      map.insert(i, "changed");
+  }
+  reader.join();
+
+  BOOST_CHECK(consistent);
+  BOOST_CHECK_EQUAL(map.getSize(), 500u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
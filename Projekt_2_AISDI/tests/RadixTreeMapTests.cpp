@@ -0,0 +1,186 @@
+#include <RadixTreeMap.h>
+
+#include <cstdint>
+#include <string>
+#include <map>
+#include <random>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/mpl/list.hpp>
+
+using TestedKeyTypes = boost::mpl::list<std::int32_t, std::uint64_t>;
+
+template <typename K>
+using Map = aisdi::RadixTreeMap<K, std::string>;
+
+using std::begin;
+using std::end;
+
+BOOST_AUTO_TEST_SUITE(RadixTreeMapTests)
+
+template <typename K, typename V>
+void thenMapContainsItems(const aisdi::RadixTreeMap<K, V>& map,
+                          const std::map<K, V>& expected)
+{
+  BOOST_CHECK_EQUAL(map.getSize(), expected.size());
+
+  auto it = begin(map);
+  for (const auto& item : expected)
+  {
+    BOOST_REQUIRE_MESSAGE(it != end(map), "Missing required item with key: " << item.first);
+    BOOST_CHECK(it->first == item.first);
+    BOOST_CHECK(it->second == item.second);
+    BOOST_CHECK(map.valueOf(item.first) == item.second);
+    ++it;
+  }
+  BOOST_CHECK(it == end(map));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenCreatedWithDefaultConstructor_ThenItIsEmpty,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map;
+
+  BOOST_CHECK(map.isEmpty());
+  BOOST_CHECK(begin(map) == end(map));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenInsertingAndRemovingManyItems_ThenItemsAreKeptInOrder,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  std::map<K, std::string> expected;
+  std::mt19937 random;
+
+  for (int i = 0; i < 5000; ++i)
+  {
+    //Klucze z kilku odległych skupisk - węzły wszystkich rozmiarów i długie wspólne prefiksy:
+    const K key = static_cast<K>((random() % 4) * 1000000 + random() % 700);
+    if (random() % 3 == 0 && expected.count(key) != 0)
+    {
+      map.remove(key);
+      expected.erase(key);
+    }
+    else
+    {
+      map[key] = std::to_string(i);
+      expected[key] = std::to_string(i);
+    }
+  }
+
+  thenMapContainsItems(map, expected);
+}
+
+BOOST_AUTO_TEST_CASE(GivenSignedKeys_WhenIterating_ThenNegativeKeysComeFirst)
+{
+  Map<std::int32_t> map = { { 5, "5" }, { -1, "-1" }, { 0, "0" }, { -300, "-300" }, { 256, "256" } };
+
+  std::vector<std::int32_t> keys;
+  for (const auto& item : map)
+    keys.push_back(item.first);
+
+  const std::vector<std::int32_t> expected = { -300, -1, 0, 5, 256 };
+  BOOST_CHECK(keys == expected);
+}
+
+BOOST_AUTO_TEST_CASE(GivenStringKeysThatArePrefixesOfOthers_WhenIterating_ThenShorterKeyComesFirst)
+{
+  aisdi::RadixTreeMap<std::string, int> map;
+  const std::vector<std::string> keys = { "abc", "", "ab", "abcdefghijklmnopqrstuvwxyz", "abd",
+                                          "abcdefghijklmnopqrstuvwxy", std::string("a\0b", 3), "b" };
+  std::map<std::string, int> expected;
+  for (std::size_t i = 0; i < keys.size(); ++i)
+  {
+    map[keys[i]] = static_cast<int>(i);
+    expected[keys[i]] = static_cast<int>(i);
+  }
+
+  thenMapContainsItems(map, expected);
+
+  map.remove("ab");
+  map.remove("abcdefghijklmnopqrstuvwxy");
+  expected.erase("ab");
+  expected.erase("abcdefghijklmnopqrstuvwxy");
+  thenMapContainsItems(map, expected);
+  BOOST_CHECK(map.find("abcdefghijklmnopqrstuvwx") == end(map));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenRemovingNotExistingKey_ThenExceptionIsThrown,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 1, "1" }, { 300, "300" } };
+
+  BOOST_CHECK_THROW(map.remove(2), std::out_of_range);
+  BOOST_CHECK_THROW(map.valueOf(2), std::out_of_range);
+  BOOST_CHECK_THROW(map.remove(end(map)), std::out_of_range);
+  BOOST_CHECK_EQUAL(map.getSize(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenSearchingBounds_ThenResultMatchesStdMap,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  std::map<K, std::string> expected;
+  std::mt19937 random;
+  for (int i = 0; i < 1000; ++i)
+  {
+    const K key = static_cast<K>(random() % 100000);
+    map[key] = "";
+    expected[key] = "";
+  }
+
+  for (int i = 0; i < 1000; ++i)
+  {
+    const K key = static_cast<K>(random() % 100001);
+    const auto lower = expected.lower_bound(key);
+    const auto upper = expected.upper_bound(key);
+    const auto range = map.equalRange(key);
+    BOOST_REQUIRE((range.first == end(map)) == (lower == expected.end()));
+    BOOST_REQUIRE((range.second == end(map)) == (upper == expected.end()));
+    if (lower != expected.end())
+      BOOST_CHECK_EQUAL(range.first->first, lower->first);
+    if (upper != expected.end())
+      BOOST_CHECK_EQUAL(range.second->first, upper->first);
+  }
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenIteratingOverRange_ThenOnlyKeysInRangeAreVisited,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  for (K i = 0; i < 1000; i += 3)
+    map[i] = std::to_string(i);
+
+  std::vector<K> keys;
+  map.forEachInRange(100, 200, [&keys](const typename Map<K>::value_type& item) { keys.push_back(item.first); });
+
+  BOOST_REQUIRE_EQUAL(keys.size(), 33u);
+  BOOST_CHECK_EQUAL(keys.front(), 102u);
+  BOOST_CHECK_EQUAL(keys.back(), 198u);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenDecrementingFromEnd_ThenItemsAreVisitedInDescendingOrder,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  for (K i = 0; i < 500; ++i)
+    map[i * 7919 % 500] = std::to_string(i);
+  const Map<K> copy = map;
+
+  auto it = end(copy);
+  for (K i = 500; i > 0; --i)
+    BOOST_REQUIRE_EQUAL((--it)->first, i - 1);
+  BOOST_CHECK(it == begin(copy));
+  BOOST_CHECK_THROW(--it, std::out_of_range);
+  BOOST_CHECK(copy == map);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -3,6 +3,13 @@
 #include <cstdint>
 #include <string>
 #include <map>
+#include <random>
+#include <algorithm>
+#include <functional>
+#include <vector>
+#include <iterator>
+#include <limits>
+#include <thread>
 
 #include <boost/test/unit_test.hpp>
 
@@ -16,7 +23,7 @@ using Map = aisdi::TreeMap<K, std::string>;
 using std::begin;
 using std::end;
 
-BOOST_AUTO_TEST_SUITE(MapsTests)
+BOOST_AUTO_TEST_SUITE(TreeMapTests)
 
 template <typename K>
 void thenMapContainsItems(const Map<K>& map,
@@ -591,6 +598,1009 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenTwoMapsWithDifferentKeys_WhenComparingThem_Th
   BOOST_CHECK(map != other);
 }
 
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenInsertingAndRemovingManyItems_ThenItemsAreKeptInOrder,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  std::map<K, std::string> expected;
+  std::mt19937 random;
+  for (int i = 0; i < 5000; ++i)
+  {
+    K key = random() % 2000;
+    if (random() % 3 == 0 && expected.count(key) != 0)
+    {
+      map.remove(key);
+      expected.erase(key);
+    }
+    else
+    {
+      map[key] = std::to_string(i);
+      expected[key] = std::to_string(i);
+    }
+  }
+
+  thenMapContainsItems(map, expected);
+  BOOST_CHECK(std::equal(expected.begin(), expected.end(), map.begin()));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenRemovingInnerNodesByIterator_ThenOtherItemsAreKept,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  std::map<K, std::string> expected;
+  for (K i = 0; i < 100; ++i)
+  {
+    map[i] = std::to_string(i);
+    expected[i] = std::to_string(i);
+  }
+
+  for (K i = 0; i < 100; i += 4)
+  {
+    map.remove(map.find(i));
+    expected.erase(i);
+  }
+
+  thenMapContainsItems(map, expected);
+  BOOST_CHECK(std::equal(expected.begin(), expected.end(), map.begin()));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenAskingForBounds_ThenEndIsReturned,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+
+  BOOST_CHECK(map.lowerBound(42) == map.end());
+  BOOST_CHECK(map.upperBound(42) == map.end());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenAskingForLowerBound_ThenFirstNotLessItemIsReturned,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 10, "Alice" }, { 20, "Bob" }, { 30, "Chuck" } };
+
+  BOOST_CHECK_EQUAL(map.lowerBound(5)->first, 10);
+  BOOST_CHECK_EQUAL(map.lowerBound(20)->first, 20);
+  BOOST_CHECK_EQUAL(map.lowerBound(21)->first, 30);
+  BOOST_CHECK(map.lowerBound(31) == map.end());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenAskingForUpperBound_ThenFirstGreaterItemIsReturned,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map = { { 10, "Alice" }, { 20, "Bob" }, { 30, "Chuck" } };
+
+  BOOST_CHECK_EQUAL(map.upperBound(5)->first, 10);
+  BOOST_CHECK_EQUAL(map.upperBound(20)->first, 30);
+  BOOST_CHECK(map.upperBound(30) == map.end());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenAskingForEqualRange_ThenRangeCoversOnlyMatchingItem,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 10, "Alice" }, { 20, "Bob" }, { 30, "Chuck" } };
+
+  auto range = map.equalRange(20);
+  BOOST_REQUIRE(range.first != map.end());
+  BOOST_CHECK_EQUAL(range.first->second, "Bob");
+  BOOST_CHECK(++range.first == range.second);
+
+  auto missing = map.equalRange(25);
+  BOOST_CHECK(missing.first == missing.second);
+  BOOST_CHECK_EQUAL(missing.first->first, 30);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenIteratingOverRange_ThenOnlyItemsInHalfOpenRangeAreVisited,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  std::map<K, std::string> expected;
+  for (K i = 0; i < 200; i += 3)
+  {
+    map[i] = std::to_string(i);
+    if (i >= 50 && i < 100)
+      expected[i] = std::to_string(i);
+  }
+
+  std::map<K, std::string> visited;
+  K previous = 0;
+  map.forEachInRange(50, 100, [&](typename Map<K>::value_type& item)
+  {
+    BOOST_CHECK(visited.empty() || previous < item.first);
+    previous = item.first;
+    visited.insert(item);
+    item.second += "!";
+  });
+
+  BOOST_CHECK(visited == expected);
+  BOOST_CHECK_EQUAL(map.valueOf(51), "51!");
+  BOOST_CHECK_EQUAL(map.valueOf(48), "48");
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenIteratingOverEmptyRange_ThenNothingIsVisited,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map = { { 10, "Alice" }, { 20, "Bob" } };
+  int visits = 0;
+
+  map.forEachInRange(11, 20, [&](const typename Map<K>::value_type&) { ++visits; });
+  map.forEachInRange(20, 20, [&](const typename Map<K>::value_type&) { ++visits; });
+
+  BOOST_CHECK_EQUAL(visits, 0);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenAskingForRank_ThenNumberOfSmallerKeysIsReturned,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map = { { 10, "Alice" }, { 20, "Bob" }, { 30, "Chuck" } };
+
+  BOOST_CHECK_EQUAL(map.rank(5), 0u);
+  BOOST_CHECK_EQUAL(map.rank(10), 0u);
+  BOOST_CHECK_EQUAL(map.rank(20), 1u);
+  BOOST_CHECK_EQUAL(map.rank(25), 2u);
+  BOOST_CHECK_EQUAL(map.rank(31), 3u);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenSelectingByIndex_ThenItemAtThatPositionIsReturned,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 30, "Chuck" }, { 10, "Alice" }, { 20, "Bob" } };
+
+  BOOST_CHECK_EQUAL(map.select(0)->second, "Alice");
+  BOOST_CHECK_EQUAL(map.select(1)->second, "Bob");
+  BOOST_CHECK_EQUAL(map.select(2)->second, "Chuck");
+  BOOST_CHECK_THROW(map.select(3), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenInsertingAndRemovingManyItems_ThenOrderStatisticsAreKept,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  std::map<K, std::string> expected;
+  std::mt19937 random;
+  for (int i = 0; i < 5000; ++i)
+  {
+    K key = random() % 2000;
+    if (random() % 2 == 0 && expected.count(key) != 0)
+    {
+      map.remove(key);
+      expected.erase(key);
+    }
+    else
+    {
+      map[key] = std::to_string(i);
+      expected[key] = std::to_string(i);
+    }
+  }
+
+  std::size_t index = 0;
+  for (const auto& item : expected)
+  {
+    BOOST_CHECK_EQUAL(map.rank(item.first), index);
+    BOOST_CHECK_EQUAL(map.select(index)->first, item.first);
+    ++index;
+  }
+  for (K lo = 0; lo < 2000; lo += 170)
+    for (K hi = 0; hi < 2000; hi += 230)
+    {
+      const std::size_t count = lo < hi ? std::distance(expected.lower_bound(lo), expected.lower_bound(hi)) : 0;
+      BOOST_CHECK_EQUAL(map.countInRange(lo, hi), count);
+    }
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenSortedItems_WhenBuildingMapFromThem_ThenMapContainsAllItems,
+                              K,
+                              TestedKeyTypes)
+{
+  std::map<K, std::string> expected;
+  for (K i = 0; i < 1000; ++i)
+    expected[i * 3] = std::to_string(i);
+
+  Map<K> map = Map<K>::buildFromSorted(expected.begin(), expected.end());
+
+  thenMapContainsItems(map, expected);
+  BOOST_CHECK(std::equal(expected.begin(), expected.end(), map.begin()));
+  BOOST_CHECK_EQUAL(map.select(500)->first, 1500);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyRange_WhenBuildingMapFromIt_ThenMapIsEmpty,
+                              K,
+                              TestedKeyTypes)
+{
+  std::map<K, std::string> items;
+
+  Map<K> map = Map<K>::buildFromSorted(items.begin(), items.end());
+
+  BOOST_CHECK(map.isEmpty());
+  BOOST_CHECK(map.begin() == map.end());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenUnsortedItems_WhenBuildingMapFromThem_ThenExceptionIsThrown,
+                              K,
+                              TestedKeyTypes)
+{
+  std::vector<std::pair<K, std::string>> items = { { 1, "Alice" }, { 3, "Bob" }, { 2, "Chuck" } };
+
+  BOOST_CHECK_THROW(Map<K>::buildFromSorted(items.begin(), items.end()), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenBuiltMap_WhenModifyingIt_ThenItStaysConsistent,
+                              K,
+                              TestedKeyTypes)
+{
+  std::map<K, std::string> expected;
+  for (K i = 0; i < 100; ++i)
+    expected[i * 2] = std::to_string(i);
+  Map<K> map = Map<K>::buildFromSorted(expected.begin(), expected.end());
+
+  for (K i = 0; i < 200; i += 3)
+  {
+    map[i] = "new";
+    expected[i] = "new";
+  }
+  for (K i = 0; i < 200; i += 8)
+  {
+    map.remove(i);
+    expected.erase(i);
+  }
+
+  thenMapContainsItems(map, expected);
+  BOOST_CHECK(std::equal(expected.begin(), expected.end(), map.begin()));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenLargeMap_WhenCopyingIt_ThenCopyIsEqualAndIndependent,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  for (K i = 0; i < 1000; ++i)
+    map[i * 7 % 1000] = std::to_string(i);
+
+  Map<K> copy{map};
+  BOOST_CHECK(copy == map);
+  BOOST_CHECK_EQUAL(copy.rank(500), 500u);
+
+  copy.remove(500);
+  copy[2000] = "new";
+  BOOST_CHECK_EQUAL(map.getSize(), 1000u);
+  BOOST_CHECK(map.find(500) != map.end());
+  BOOST_CHECK(map.find(2000) == map.end());
+  BOOST_CHECK_EQUAL(copy.rank(2000), 999u);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMovedFromMap_WhenReusingIt_ThenBothMapsAreIndependent,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  for (K i = 0; i < 100; ++i)
+    map[i] = std::to_string(i);
+
+  Map<K> other{std::move(map)};
+  for (K i = 0; i < 50; ++i)
+    map[i] = "new";
+  for (K i = 0; i < 100; i += 2)
+    other.remove(i);
+
+  BOOST_CHECK_EQUAL(map.getSize(), 50u);
+  BOOST_CHECK_EQUAL(other.getSize(), 50u);
+  BOOST_CHECK_EQUAL(map.valueOf(1), "new");
+  BOOST_CHECK_EQUAL(other.valueOf(1), "1");
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenSplittingIt_ThenSmallerKeysStayAndOthersAreReturned,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  std::map<K, std::string> less, notLess;
+  for (K i = 0; i < 500; ++i)
+  {
+    map[i * 2] = std::to_string(i);
+    (i * 2 < 400 ? less : notLess)[i * 2] = std::to_string(i);
+  }
+
+  Map<K> other = map.split(400);
+
+  thenMapContainsItems(map, less);
+  thenMapContainsItems(other, notLess);
+  BOOST_CHECK_EQUAL(other.begin()->first, 400);
+  BOOST_CHECK_EQUAL(other.rank(500), 50u);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenSplitMaps_WhenJoiningThem_ThenAllItemsAreBack,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  std::map<K, std::string> expected;
+  for (K i = 0; i < 500; ++i)
+  {
+    map[i] = std::to_string(i);
+    expected[i] = std::to_string(i);
+  }
+
+  Map<K> upper = map.split(123);
+  upper.join(std::move(map));
+
+  thenMapContainsItems(upper, expected);
+  BOOST_CHECK(std::equal(expected.begin(), expected.end(), upper.begin()));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapsWithOverlappingKeys_WhenJoiningThem_ThenExceptionIsThrown,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 10, "Alice" }, { 30, "Chuck" } };
+  Map<K> other = { { 20, "Bob" } };
+
+  BOOST_CHECK_THROW(map.join(other), std::invalid_argument);
+  BOOST_CHECK_EQUAL(map.getSize(), 2u);
+}
+
+template <typename K>
+void givenTwoMaps(Map<K>& first, std::map<K, std::string>& firstItems,
+                  Map<K>& second, std::map<K, std::string>& secondItems, int count)
+{
+  std::mt19937 random;
+  for (int i = 0; i < count; ++i)
+  {
+    K key = random() % (2 * count);
+    first[key] = firstItems[key] = "first" + std::to_string(i);
+    key = random() % (2 * count);
+    second[key] = secondItems[key] = "second" + std::to_string(i);
+  }
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenTwoMaps_WhenUnitingThem_ThenAllKeysArePresentAndFirstValuesWin,
+                              K,
+                              TestedKeyTypes)
+{
+  for (bool parallel : { false, true })
+  {
+    Map<K> map, other;
+    std::map<K, std::string> expected, otherItems;
+    givenTwoMaps(map, expected, other, otherItems, 50000);
+    expected.insert(otherItems.begin(), otherItems.end());
+
+    map.unionWith(std::move(other), parallel);
+
+    thenMapContainsItems(map, expected);
+    BOOST_CHECK(std::equal(expected.begin(), expected.end(), map.begin()));
+  }
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenTwoMaps_WhenIntersectingThem_ThenOnlyCommonKeysRemain,
+                              K,
+                              TestedKeyTypes)
+{
+  for (bool parallel : { false, true })
+  {
+    Map<K> map, other;
+    std::map<K, std::string> items, otherItems, expected;
+    givenTwoMaps(map, items, other, otherItems, 50000);
+    for (const auto& item : items)
+      if (otherItems.count(item.first) != 0)
+        expected.insert(item);
+
+    map.intersect(other, parallel);
+
+    thenMapContainsItems(map, expected);
+    BOOST_CHECK_EQUAL(other.getSize(), otherItems.size());
+  }
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenTwoMaps_WhenSubtractingThem_ThenOnlyKeysMissingInOtherRemain,
+                              K,
+                              TestedKeyTypes)
+{
+  for (bool parallel : { false, true })
+  {
+    Map<K> map, other;
+    std::map<K, std::string> items, otherItems, expected;
+    givenTwoMaps(map, items, other, otherItems, 50000);
+    for (const auto& item : items)
+      if (otherItems.count(item.first) == 0)
+        expected.insert(item);
+
+    map.difference(std::move(other), parallel);
+
+    thenMapContainsItems(map, expected);
+    BOOST_CHECK(std::equal(expected.begin(), expected.end(), map.begin()));
+  }
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNearlySortedKeys_WhenInsertingWithHints_ThenMapContainsAllItems,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  std::map<K, std::string> expected;
+  std::mt19937 random;
+  auto hint = map.end();
+  for (K i = 0; i < 3000; ++i)
+  {
+    K key = i * 4 + random() % 16;
+    hint = map.insert(hint, key, std::to_string(i));
+    expected[key] = std::to_string(i);
+    BOOST_CHECK_EQUAL(hint->first, key);
+  }
+
+  thenMapContainsItems(map, expected);
+  BOOST_CHECK(std::equal(expected.begin(), expected.end(), map.begin()));
+}
+
+//Komparator liczący wywołania:
+template <typename K>
+struct CountingLess
+{
+  explicit CountingLess(std::size_t* pCount = nullptr) : count(pCount) {}
+
+  bool operator()(const K& left, const K& right) const
+  {
+    ++*count;
+    return left < right;
+  }
+
+  std::size_t* count;
+};
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenSortedKeys_WhenInsertingWithPreviousIteratorAsHint_ThenComparisonsPerInsertAreConstant,
+                              K,
+                              TestedKeyTypes)
+{
+  std::size_t comparisons = 0;
+  aisdi::TreeMap<K, std::string, CountingLess<K>> map{ CountingLess<K>(&comparisons) };
+  const K count = 20000;
+
+  auto hint = map.end();
+  for (K i = 0; i < count; ++i)
+    hint = map.insert(hint, i * 2, "");
+  const std::size_t ascending = comparisons;
+  comparisons = 0;
+  hint = map.begin();
+  for (K i = 0; i < count; ++i)
+    hint = ++map.insert(hint, i * 2 + 1, "");//luki wypełniane po kolei w środku drzewa
+
+  BOOST_CHECK_EQUAL(map.getSize(), static_cast<std::size_t>(2 * count));
+  BOOST_CHECK_LE(ascending, static_cast<std::size_t>(5 * count));//wspinaczka po grzbiecie: ~log2(n) na wstawienie
+  BOOST_CHECK_LE(comparisons, static_cast<std::size_t>(5 * count));
+  K expected = 0;
+  for (const auto& item : map)
+    BOOST_REQUIRE_EQUAL(item.first, expected++);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenExistingKey_WhenInsertingWithHint_ThenValueIsReplaced,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 10, "Alice" }, { 20, "Bob" }, { 30, "Chuck" } };
+
+  auto it = map.insert(map.find(30), 10, "Dan");
+
+  BOOST_CHECK_EQUAL(it->first, 10);
+  BOOST_CHECK_EQUAL(map.valueOf(10), "Dan");
+  BOOST_CHECK_EQUAL(map.getSize(), 3u);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenAnyHint_WhenFindingFromIt_ThenResultIsTheSameAsWithoutHint,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  for (K i = 0; i < 200; i += 2)
+    map[i] = std::to_string(i);
+
+  for (auto hint = map.begin(); hint != map.end(); ++hint)
+    for (K key = 0; key < 201; key += 7)
+    {
+      auto found = map.find(hint, key);
+      BOOST_CHECK(found == map.find(key));
+    }
+  BOOST_CHECK(map.find(map.end(), 42) == map.find(42));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithReversedComparator_WhenIterating_ThenKeysAreInDescendingOrder,
+                              K,
+                              TestedKeyTypes)
+{
+  aisdi::TreeMap<K, std::string, std::greater<K>> map;
+  for (K i = 0; i < 100; ++i)
+    map[i * 7 % 100] = std::to_string(i);
+
+  K expected = 99;
+  for (const auto& item : map)
+    BOOST_CHECK_EQUAL(item.first, expected--);
+  BOOST_CHECK_EQUAL(map.lowerBound(50)->first, 50);
+  BOOST_CHECK_EQUAL(map.upperBound(50)->first, 49);
+  BOOST_CHECK_EQUAL(map.rank(90), 9u);
+  map.remove(50);
+  BOOST_CHECK(map.find(50) == map.end());
+}
+
+//Klucz wyszukiwania innego typu niż klucz mapy i do niego nieprzekształcalny:
+struct Id
+{
+  int value;
+};
+
+template <typename K>
+struct IdLess
+{
+  using is_transparent = void;
+
+  bool operator()(const K& left, const K& right) const { return left < right; }
+  bool operator()(const K& left, const Id& right) const { return left < static_cast<K>(right.value); }
+  bool operator()(const Id& left, const K& right) const { return static_cast<K>(left.value) < right; }
+};
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithTransparentComparator_WhenLookingUpByOtherType_ThenItemsAreFound,
+                              K,
+                              TestedKeyTypes)
+{
+  aisdi::TreeMap<K, std::string, IdLess<K>> map;
+  for (K i = 0; i < 100; i += 2)
+    map[i] = std::to_string(i);
+
+  BOOST_CHECK_EQUAL(map.find(Id{ 42 })->second, "42");
+  BOOST_CHECK(map.find(Id{ 43 }) == map.end());
+  BOOST_CHECK_EQUAL(map.lowerBound(Id{ 43 })->first, 44);
+  BOOST_CHECK_EQUAL(map.upperBound(Id{ 44 })->first, 46);
+  BOOST_CHECK(map.equalRange(Id{ 44 }).first == map.find(44));
+  BOOST_CHECK_EQUAL(map.rank(Id{ 10 }), 5u);
+  BOOST_CHECK_EQUAL(map.countInRange(Id{ 10 }, Id{ 20 }), 5u);
+  BOOST_CHECK_EQUAL(map.countInRange(Id{ 20 }, Id{ 10 }), 0u);
+}
+
+//Komparator ze stanem - domyślnie skonstruowany porządkuje rosnąco:
+template <typename K>
+struct DirectionLess
+{
+  DirectionLess() : descending(false) {}
+  explicit DirectionLess(bool pDescending) : descending(pDescending) {}
+
+  bool operator()(const K& left, const K& right) const { return descending ? right < left : left < right; }
+
+  bool descending;
+};
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithStatefulComparator_WhenSplittingIt_ThenBothPartsKeepItsOrdering,
+                              K,
+                              TestedKeyTypes)
+{
+  aisdi::TreeMap<K, std::string, DirectionLess<K>> map(DirectionLess<K>(true));
+  for (K i = 0; i < 200; ++i)
+    map[i * 7 % 200] = std::to_string(i * 7 % 200);
+
+  auto lower = map.split(100);//klucze <= 100 w porządku malejącym
+
+  BOOST_CHECK_EQUAL(map.getSize(), 99u);
+  BOOST_CHECK_EQUAL(lower.getSize(), 101u);
+  BOOST_CHECK_EQUAL(lower.begin()->first, 100);
+  for (K i = 0; i < 200; ++i)
+  {
+    auto& part = i > 100 ? map : lower;
+    BOOST_REQUIRE(part.find(i) != part.end());
+    BOOST_CHECK_EQUAL(part.valueOf(i), std::to_string(i));
+  }
+  lower[300] = "300";//większy klucz trafia na początek w porządku malejącym
+  BOOST_CHECK_EQUAL(lower.begin()->first, 300);
+  lower.remove(300);
+  map.join(std::move(lower));
+  K expected = 199;
+  for (const auto& item : map)
+    BOOST_CHECK_EQUAL(item.first, expected--);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenFrozenMap_WhenFindingKeys_ThenResultsMatchOriginalMap,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  for (K i = 0; i < 1000; i += 3)
+    map[i] = std::to_string(i);
+
+  const auto frozen = map.freeze();
+
+  BOOST_CHECK_EQUAL(frozen.getSize(), map.getSize());
+  for (K i = 0; i < 1002; ++i)
+  {
+    const auto it = frozen.find(i);
+    if (map.find(i) == map.end())
+      BOOST_CHECK(it == frozen.end());
+    else
+      BOOST_CHECK_EQUAL(it->second, std::to_string(i));
+  }
+  BOOST_CHECK_EQUAL(frozen.valueOf(42), "42");
+  BOOST_CHECK_THROW(frozen.valueOf(43), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenFrozenMap_WhenAskingForLowerBound_ThenFirstNotLessItemIsReturned,
+                              K,
+                              TestedKeyTypes)
+{
+  for (K size = 0; size < 40; ++size)
+  {
+    Map<K> map;
+    for (K i = 0; i < size; ++i)
+      map[2 * i + 1] = std::to_string(i);
+    const auto frozen = map.freeze();
+
+    for (K key = 0; key <= 2 * size + 1; ++key)
+    {
+      const auto it = frozen.lowerBound(key);
+      const auto expected = map.lowerBound(key);
+      if (expected == map.end())
+        BOOST_CHECK(it == frozen.end());
+      else
+        BOOST_REQUIRE(it != frozen.end() && it->first == expected->first);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenFrozenMap_WhenIterating_ThenItemsAreInOrderAndIndependentOfOriginal,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 5, "5" }, { 1, "1" }, { 3, "3" } };
+  const auto frozen = map.freeze();
+
+  map[2] = "2";
+  map.remove(5);
+
+  const std::vector<K> expected = { 1, 3, 5 };
+  std::vector<K> keys;
+  for (const auto& item : frozen)
+    keys.push_back(item.first);
+  BOOST_CHECK(keys == expected);
+  BOOST_CHECK((aisdi::FrozenMap<K, std::string>().isEmpty()));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenFrozenMap_WhenAssigningItToOther_ThenBothHaveTheSameItems,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  for (K i = 0; i < 100; ++i)
+    map[i * 3] = std::to_string(i);
+  const auto frozen = map.freeze();
+  auto other = Map<K>{ { 7, "7" } }.freeze();
+
+  other = frozen;
+  BOOST_CHECK_EQUAL(other.getSize(), 100u);
+  BOOST_CHECK_EQUAL(other.valueOf(42), "14");
+  BOOST_CHECK(other.find(7) == other.end());
+  BOOST_CHECK(std::equal(frozen.begin(), frozen.end(), other.begin()));
+
+  other = aisdi::FrozenMap<K, std::string>();
+  BOOST_CHECK(other.isEmpty());
+  BOOST_CHECK(other.find(42) == other.end());
+  BOOST_CHECK_EQUAL(frozen.valueOf(42), "14");
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithSumAggregate_WhenAskingForRanges_ThenSumsOfValuesInRangeAreReturned,
+                              K,
+                              TestedKeyTypes)
+{
+  aisdi::TreeMap<K, long, std::less<K>, aisdi::SumAggregate<long>> map;
+  for (K i = 0; i < 100; ++i)
+    map[i] = static_cast<long>(i);
+
+  BOOST_CHECK_EQUAL(map.aggregate(), 4950);
+  BOOST_CHECK_EQUAL(map.aggregate(10, 20), 145);
+  BOOST_CHECK_EQUAL(map.aggregate(20, 10), 0);
+  BOOST_CHECK_EQUAL(map.aggregate(90, 1000), 945);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithMaxAggregate_WhenChangingValuesThroughReferences_ThenAggregateFollows,
+                              K,
+                              TestedKeyTypes)
+{
+  aisdi::TreeMap<K, int, std::less<K>, aisdi::MaxAggregate<int>> map;
+  for (K i = 0; i < 50; ++i)
+    map[i] = 1;
+  BOOST_CHECK_EQUAL(map.aggregate(0, 50), 1);
+
+  map[10] = 7;
+  map.find(30)->second = 9;
+  map.valueOf(40) = 8;
+  for (auto&& item : map)
+    if (item.first == 45)
+      item.second = 5;
+
+  BOOST_CHECK_EQUAL(map.aggregate(0, 20), 7);
+  BOOST_CHECK_EQUAL(map.aggregate(20, 35), 9);
+  BOOST_CHECK_EQUAL(map.aggregate(35, 50), 8);
+  BOOST_CHECK_EQUAL(map.aggregate(41, 50), 5);
+  BOOST_CHECK_EQUAL(map.aggregate(50, 60), std::numeric_limits<int>::lowest());
+}
+
+//Łączenie kluczy w kolejności - monoid nieprzemienny:
+struct KeyList
+{
+  using result_type = std::string;
+
+  static result_type identity() { return std::string(); }
+
+  template <typename K>
+  static result_type lift(const K& key, const std::string&) { return std::to_string(key) + " "; }
+
+  static result_type combine(const result_type& left, const result_type& right) { return left + right; }
+};
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithOrderedAggregate_WhenInsertingRemovingAndSplitting_ThenOrderIsKept,
+                              K,
+                              TestedKeyTypes)
+{
+  aisdi::TreeMap<K, std::string, std::less<K>, KeyList> map;
+  std::map<K, std::string> expected;
+  std::mt19937 random;
+
+  for (int i = 0; i < 1000; ++i)
+  {
+    const K key = static_cast<K>(random() % 200);
+    if (random() % 3 == 0 && expected.count(key) != 0)
+    {
+      map.remove(key);
+      expected.erase(key);
+    }
+    else
+    {
+      map[key] = "x";
+      expected[key] = "x";
+    }
+  }
+
+  std::string keys;
+  for (auto it = expected.lower_bound(50); it != expected.end() && it->first < 150; ++it)
+    keys += std::to_string(it->first) + " ";
+  BOOST_CHECK_EQUAL(map.aggregate(50, 150), keys);
+
+  auto upper = map.split(100);
+  std::string lowerKeys, upperKeys;
+  for (const auto& item : expected)
+    (item.first < 100 ? lowerKeys : upperKeys) += std::to_string(item.first) + " ";
+  BOOST_CHECK_EQUAL(map.aggregate(), lowerKeys);
+  BOOST_CHECK_EQUAL(upper.aggregate(), upperKeys);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithManyItems_WhenDecrementingFromEnd_ThenItemsAreVisitedInDescendingOrder,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  std::mt19937 random;
+  std::map<K, std::string> expected;
+  for (int i = 0; i < 500; ++i)
+  {
+    const K key = static_cast<K>(random() % 1000);
+    map[key] = std::to_string(i);
+    expected[key] = std::to_string(i);
+  }
+
+  auto it = map.end();
+  for (auto item = expected.rbegin(); item != expected.rend(); ++item)
+  {
+    --it;
+    BOOST_REQUIRE_EQUAL(it->first, item->first);
+    BOOST_CHECK_EQUAL(it->second, item->second);
+  }
+  BOOST_CHECK(it == map.begin());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapsAfterStructuralChanges_WhenIterating_ThenBothDirectionsAgree,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  Map<K> other;
+  for (K i = 0; i < 300; ++i)
+  {
+    map[3 * i] = "a";
+    other[2 * i] = "b";
+  }
+  map.unionWith(other);
+  map.difference(Map<K>{ { 0, "" }, { 6, "" }, { 598, "" } });
+  Map<K> greater = map.split(300);
+  greater.remove(300);
+  map.join(std::move(greater));
+  const Map<K> copy = map;
+
+  std::vector<K> forward, backward;
+  for (const auto& item : copy)
+    forward.push_back(item.first);
+  for (auto it = copy.end(); it != copy.begin();)
+    backward.push_back((--it)->first);
+  std::reverse(backward.begin(), backward.end());
+
+  BOOST_CHECK_EQUAL(forward.size(), copy.getSize());
+  BOOST_CHECK(std::is_sorted(forward.begin(), forward.end()));
+  BOOST_CHECK(forward == backward);
+  BOOST_CHECK_EQUAL(copy.getSize(), map.getSize());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenClearing_ThenItIsEmptyAndCanBeReused,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  for (K i = 0; i < 1000; ++i)
+    map[i] = std::to_string(i);
+
+  map.clear();
+
+  BOOST_CHECK(map.isEmpty());
+  BOOST_CHECK_EQUAL(map.getSize(), 0u);
+  BOOST_CHECK(map.begin() == map.end());
+  BOOST_CHECK(map.find(1) == map.end());
+
+  map[7] = "7";
+  map[3] = "3";
+  thenMapContainsItems(map, { { 3, "3" }, { 7, "7" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithAggregate_WhenClearing_ThenAggregateIsIdentity,
+                              K,
+                              TestedKeyTypes)
+{
+  aisdi::TreeMap<K, K, std::less<K>, aisdi::SumAggregate<K>> map;
+  for (K i = 0; i < 100; ++i)
+    map[i] = i;
+
+  map.clear();
+
+  BOOST_CHECK_EQUAL(map.aggregate(), K{});
+  map[1] = 5;
+  BOOST_CHECK_EQUAL(map.aggregate(), 5u);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenErasingRange_ThenOnlyKeysInRangeAreRemoved,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  std::map<K, std::string> expected;
+  for (K i = 0; i < 1000; i += 2)
+  {
+    map[i] = std::to_string(i);
+    expected[i] = std::to_string(i);
+  }
+
+  BOOST_CHECK_EQUAL(map.eraseRange(101, 700), 299u);
+  expected.erase(expected.lower_bound(101), expected.lower_bound(700));
+  thenMapContainsItems(map, expected);
+
+  BOOST_CHECK_EQUAL(map.eraseRange(101, 700), 0u);
+  BOOST_CHECK_EQUAL(map.eraseRange(50, 10), 0u);
+  BOOST_CHECK_EQUAL(map.eraseRange(0, 2000), expected.size());
+  BOOST_CHECK(map.isEmpty());
+  BOOST_CHECK(map.begin() == map.end());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithAggregate_WhenErasingRange_ThenAggregateCoversRemainingItems,
+                              K,
+                              TestedKeyTypes)
+{
+  aisdi::TreeMap<K, K, std::less<K>, aisdi::SumAggregate<K>> map;
+  for (K i = 0; i < 100; ++i)
+    map[i] = i;
+
+  map.eraseRange(10, 90);
+
+  BOOST_CHECK_EQUAL(map.aggregate(), 45u + 945u);
+  BOOST_CHECK_EQUAL(map.getSize(), 20u);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithDirtyAggregate_WhenReadingItFromManyThreads_ThenAllSeeTheSameSums,
+                              K,
+                              TestedKeyTypes)
+{
+  aisdi::TreeMap<K, K, std::less<K>, aisdi::SumAggregate<K>> map;
+  for (K i = 0; i < 1000; ++i)
+    map[i] = 1;
+  for (K i = 0; i < 1000; i += 2)
+    map[i] = 3;
+
+  const auto& constMap = map;
+  std::vector<K> totals(4);
+  std::vector<K> ranges(4);
+  std::vector<std::thread> threads;
+  for (std::size_t t = 0; t < totals.size(); ++t)
+    threads.emplace_back([&constMap, &totals, &ranges, t]() {
+      totals[t] = constMap.aggregate();
+      ranges[t] = constMap.aggregate(100, 200);
+    });
+  for (auto& thread : threads)
+    thread.join();
+
+  for (std::size_t t = 0; t < totals.size(); ++t)
+  {
+    BOOST_CHECK_EQUAL(totals[t], 2000u);
+    BOOST_CHECK_EQUAL(ranges[t], 200u);
+  }
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenRemovingByPredicate_ThenMatchingItemsAreRemoved,
+                              K,
+                              TestedKeyTypes)
+{
+  for (K step : { K(2), K(50) })
+  {
+    Map<K> map;
+    std::map<K, std::string> expected;
+    for (K i = 0; i < 1000; ++i)
+    {
+      map[i] = std::to_string(i);
+      if (i % step != 0)
+        expected[i] = std::to_string(i);
+    }
+
+    const auto removed = map.removeIf([step](const typename Map<K>::value_type& item) { return item.first % step == 0; });
+
+    BOOST_CHECK_EQUAL(removed, 1000u / step);
+    thenMapContainsItems(map, expected);
+    auto it = map.end();
+    for (auto item = expected.rbegin(); item != expected.rend(); ++item)
+      BOOST_REQUIRE_EQUAL((--it)->first, item->first);
+  }
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenIntervalMap_WhenFindingOverlaps_ThenAllOverlappingIntervalsAreReturnedInOrder,
+                              K,
+                              TestedKeyTypes)
+{
+  aisdi::IntervalMap<K> map;
+  map[10] = 20;
+  map[12] = 14;
+  map[15] = 40;
+  map[30] = 35;
+  map[50] = 60;
+
+  std::vector<K> starts;
+  map.findOverlapping(14, 31, [&starts](const std::pair<const K, K>& interval) { starts.push_back(interval.first); });
+
+  const std::vector<K> expected = { 10, 15, 30 };
+  BOOST_CHECK(starts == expected);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenRandomIntervals_WhenFindingOverlaps_ThenResultMatchesLinearScan,
+                              K,
+                              TestedKeyTypes)
+{
+  aisdi::IntervalMap<K> map;
+  std::mt19937 random;
+  for (int i = 0; i < 500; ++i)
+  {
+    const K start = static_cast<K>(random() % 1000);
+    map[start] = start + 1 + static_cast<K>(random() % 50);
+    if (i % 7 == 0)
+      map.remove(start);
+  }
+  map.find(map.begin()->first)->second += 200;
+
+  for (int query = 0; query < 100; ++query)
+  {
+    const K lo = static_cast<K>(random() % 1000);
+    const K hi = lo + 1 + static_cast<K>(random() % 30);
+    std::vector<K> expected, found;
+    for (const auto& interval : map)
+      if (interval.first < hi && lo < interval.second)
+        expected.push_back(interval.first);
+    map.findOverlapping(lo, hi, [&found](const std::pair<const K, K>& interval) { found.push_back(interval.first); });
+    BOOST_REQUIRE(found == expected);
+  }
+}
+
 // ConstIterator is tested via Iterator methods.
 // If Iterator methods are to be changed, then new ConstIterator tests are required.
 